@@ -0,0 +1,308 @@
+#include "contiki.h"
+#include "ac-controller.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* Sensor flags. */
+#define SENSOR_USED 0x01
+#define SENSOR_HOT  0x02
+
+/* Only fill the table up to 7/8, so that probe sequences stay short. */
+#define MAX_LOAD (AC_CONTROLLER_MAX_SENSORS - AC_CONTROLLER_MAX_SENSORS / 8)
+
+#define TREND_ALPHA_SHIFT 2
+
+static struct ac_sensor sensors[AC_CONTROLLER_MAX_SENSORS];
+static uint8_t sensor_count;
+
+static struct ac_zone zones[AC_CONTROLLER_ZONES];
+static uint8_t zone_state;
+
+static const struct ac_controller_callbacks *cb;
+static const struct ac_zone_map *zone_map;
+static uint8_t zone_map_len;
+
+/* The number of receivers that share the readings of the sensors. */
+static uint8_t receivers = 1;
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+slot(const linkaddr_t *addr)
+{
+  return (addr->u8[0] ^ (addr->u8[1] * 31)) & (AC_CONTROLLER_MAX_SENSORS - 1);
+}
+/*---------------------------------------------------------------------------*/
+static struct ac_sensor *
+lookup(const linkaddr_t *addr)
+{
+  uint16_t n;
+  uint8_t i;
+
+  i = slot(addr);
+  for(n = 0; n < AC_CONTROLLER_MAX_SENSORS; n++) {
+    if(!(sensors[i].flags & SENSOR_USED)) {
+      return NULL;
+    }
+    if(linkaddr_cmp(&sensors[i].addr, addr)) {
+      return &sensors[i];
+    }
+    i = (i + 1) & (AC_CONTROLLER_MAX_SENSORS - 1);
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Re-evaluate the decision of a zone from its aggregate state. This is
+   O(1), since the aggregates are kept up to date on every reading. */
+static void
+evaluate(uint8_t z)
+{
+  struct ac_zone *zone = &zones[z];
+  uint8_t on, was_on;
+  uint16_t avg;
+
+  was_on = (zone_state >> z) & 1;
+  on = was_on;
+
+  if(zone->members == 0) {
+    on = 0;
+  } else if(zone->policy == AC_POLICY_WEIGHTED_AVG) {
+    avg = zone->temp_sum / zone->weight_sum;
+    if(avg > AC_CONTROLLER_ON_TEMP) {
+      on = 1;
+    } else if(avg < AC_CONTROLLER_OFF_TEMP) {
+      on = 0;
+    }
+  } else if(zone->policy == AC_POLICY_QUORUM) {
+    on = zone->hot >= zone->quorum;
+  } else {
+    on = zone->hot > 0;
+  }
+
+  if(on != was_on) {
+    zone_state ^= 1 << z;
+    if(cb != NULL && cb->changed != NULL) {
+      cb->changed(z, on);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+zone_add(struct ac_sensor *s)
+{
+  struct ac_zone *zone = &zones[s->zone];
+
+  zone->members++;
+  zone->weight_sum += s->weight;
+  zone->temp_sum += (uint32_t)s->temp * s->weight;
+  if(s->flags & SENSOR_HOT) {
+    zone->hot++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+zone_remove(struct ac_sensor *s)
+{
+  struct ac_zone *zone = &zones[s->zone];
+
+  zone->members--;
+  zone->weight_sum -= s->weight;
+  zone->temp_sum -= (uint32_t)s->temp * s->weight;
+  if(s->flags & SENSOR_HOT) {
+    zone->hot--;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+map_sensor(struct ac_sensor *s)
+{
+  uint8_t i;
+
+  s->zone = 0;
+  s->weight = 1;
+  for(i = 0; i < zone_map_len; i++) {
+    if(linkaddr_cmp(&zone_map[i].addr, &s->addr)) {
+      if(zone_map[i].zone < AC_CONTROLLER_ZONES) {
+        s->zone = zone_map[i].zone;
+      }
+      if(zone_map[i].weight > 0) {
+        s->weight = zone_map[i].weight;
+      }
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Remove an entry from the hash table, shifting later entries of the
+   same probe sequence back so that lookups never hit a hole. */
+static void
+remove_sensor(struct ac_sensor *s)
+{
+  uint8_t i, j, k;
+
+  zone_remove(s);
+  sensor_count--;
+
+  i = s - sensors;
+  j = i;
+  while(1) {
+    sensors[i].flags = 0;
+    while(1) {
+      j = (j + 1) & (AC_CONTROLLER_MAX_SENSORS - 1);
+      if(!(sensors[j].flags & SENSOR_USED)) {
+        return;
+      }
+      k = slot(&sensors[j].addr);
+      /* Entry j can be moved into the hole at i unless its home slot k
+         lies cyclically in (i, j]. */
+      if((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) {
+        continue;
+      }
+      break;
+    }
+    memcpy(&sensors[i], &sensors[j], sizeof(struct ac_sensor));
+    i = j;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+ac_controller_init(const struct ac_controller_callbacks *callbacks,
+                   const struct ac_zone_map *map, uint8_t map_len)
+{
+  uint8_t z;
+
+  memset(sensors, 0, sizeof(sensors));
+  memset(zones, 0, sizeof(zones));
+  sensor_count = 0;
+  receivers = 1;
+  zone_state = 0;
+  cb = callbacks;
+  zone_map = map;
+  zone_map_len = map_len;
+
+  for(z = 0; z < AC_CONTROLLER_ZONES; z++) {
+    zones[z].policy = AC_POLICY_MAX;
+    zones[z].quorum = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+ac_controller_set_policy(uint8_t zone, uint8_t policy, uint8_t quorum)
+{
+  if(zone >= AC_CONTROLLER_ZONES) {
+    return;
+  }
+  zones[zone].policy = policy;
+  zones[zone].quorum = quorum > 0 ? quorum : 1;
+  evaluate(zone);
+}
+/*---------------------------------------------------------------------------*/
+void
+ac_controller_update(const linkaddr_t *from, uint8_t temp, uint8_t period)
+{
+  struct ac_sensor *s;
+  int16_t trend;
+  uint8_t i;
+
+  s = lookup(from);
+  if(s == NULL) {
+    /* If the table is full we ignore the sensor until a slot is freed
+       by ac_controller_expire(). */
+    if(sensor_count >= MAX_LOAD) {
+      return;
+    }
+    i = slot(from);
+    while(sensors[i].flags & SENSOR_USED) {
+      i = (i + 1) & (AC_CONTROLLER_MAX_SENSORS - 1);
+    }
+    s = &sensors[i];
+    linkaddr_copy(&s->addr, from);
+    s->temp = temp;
+    s->trend = 0;
+    s->flags = SENSOR_USED;
+    map_sensor(s);
+    sensor_count++;
+  } else {
+    zone_remove(s);
+    trend = s->trend + ((((int16_t)temp - s->temp) * 16 - s->trend)
+                        >> TREND_ALPHA_SHIFT);
+    s->trend = trend > 127 ? 127 : (trend < -128 ? -128 : trend);
+    s->temp = temp;
+  }
+
+  if(temp > AC_CONTROLLER_ON_TEMP) {
+    s->flags |= SENSOR_HOT;
+  } else if(temp < AC_CONTROLLER_OFF_TEMP) {
+    s->flags &= ~SENSOR_HOT;
+  }
+  s->period = period;
+  s->last_seen = (uint16_t)clock_seconds();
+
+  zone_add(s);
+  evaluate(s->zone);
+}
+/*---------------------------------------------------------------------------*/
+/* The time a sensor may stay silent. Sensors that slow down their
+   reports are kept longer, and the more receivers share the readings,
+   the fewer of them reach this one. A fast sensor is never dropped
+   sooner than SENSOR_TIMEOUT. The timeout is kept within half the range
+   of last_seen. */
+static uint16_t
+timeout(const struct ac_sensor *s)
+{
+  uint32_t t;
+
+  t = (uint32_t)s->period * AC_CONTROLLER_PERIOD_TIMEOUTS * receivers;
+  if(t < AC_CONTROLLER_SENSOR_TIMEOUT) {
+    return AC_CONTROLLER_SENSOR_TIMEOUT;
+  }
+  return t < 0x7fff ? t : 0x7fff;
+}
+/*---------------------------------------------------------------------------*/
+void
+ac_controller_set_receivers(uint8_t n)
+{
+  receivers = n > 0 ? n : 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+ac_controller_expire(void)
+{
+  uint16_t now, i;
+  uint8_t z, dirty;
+
+  now = (uint16_t)clock_seconds();
+  dirty = 0;
+  i = 0;
+  while(i < AC_CONTROLLER_MAX_SENSORS) {
+    if((sensors[i].flags & SENSOR_USED) &&
+       (uint16_t)(now - sensors[i].last_seen) > timeout(&sensors[i])) {
+      printf("Sensor %d timed out\n", sensors[i].addr.u8[0]);
+      dirty |= 1 << sensors[i].zone;
+      /* Removing may shift another entry into slot i, so look at the
+         same slot again. */
+      remove_sensor(&sensors[i]);
+      continue;
+    }
+    i++;
+  }
+
+  for(z = 0; z < AC_CONTROLLER_ZONES; z++) {
+    if(dirty & (1 << z)) {
+      evaluate(z);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+const struct ac_sensor *
+ac_controller_sensor(const linkaddr_t *addr)
+{
+  return lookup(addr);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+ac_controller_state(void)
+{
+  return zone_state;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,133 @@
+#ifndef AC_CONTROLLER_H_
+#define AC_CONTROLLER_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+/* The maximum amount of sensors the controller can track at once. The
+   sensor table is an open addressing hash table, so this must be a
+   power of two no larger than 256, and only 7/8 of it is filled. Each
+   entry costs 10 bytes of RAM. */
+#ifdef AC_CONTROLLER_CONF_MAX_SENSORS
+#define AC_CONTROLLER_MAX_SENSORS AC_CONTROLLER_CONF_MAX_SENSORS
+#else
+#define AC_CONTROLLER_MAX_SENSORS 64
+#endif
+
+/* The number of AC zones. Zone state is kept in a bitmask, so there can
+   be at most 8 of them. */
+#ifdef AC_CONTROLLER_CONF_ZONES
+#define AC_CONTROLLER_ZONES AC_CONTROLLER_CONF_ZONES
+#else
+#define AC_CONTROLLER_ZONES 4
+#endif
+
+/* A sensor reading above ON_TEMP makes the sensor hot, and it only
+   becomes cool again once it reads below OFF_TEMP. */
+#ifdef AC_CONTROLLER_CONF_ON_TEMP
+#define AC_CONTROLLER_ON_TEMP AC_CONTROLLER_CONF_ON_TEMP
+#else
+#define AC_CONTROLLER_ON_TEMP 70
+#endif
+
+#ifdef AC_CONTROLLER_CONF_OFF_TEMP
+#define AC_CONTROLLER_OFF_TEMP AC_CONTROLLER_CONF_OFF_TEMP
+#else
+#define AC_CONTROLLER_OFF_TEMP 66
+#endif
+
+/* Sensors that have not reported for this many seconds are dropped and
+   no longer take part in the zone decision. A sensor that reports less
+   often is given PERIOD_TIMEOUTS of its report periods per receiver
+   instead, see ac_controller_set_receivers(). A sensor sends each
+   reading to one receiver at random, every 1 to 1.5 periods, so a live
+   sensor is dropped with a probability below e^-(PERIOD_TIMEOUTS / 1.25),
+   about once in 600 timeouts for 8. */
+#ifdef AC_CONTROLLER_CONF_SENSOR_TIMEOUT
+#define AC_CONTROLLER_SENSOR_TIMEOUT AC_CONTROLLER_CONF_SENSOR_TIMEOUT
+#else
+#define AC_CONTROLLER_SENSOR_TIMEOUT 90
+#endif
+
+#ifdef AC_CONTROLLER_CONF_PERIOD_TIMEOUTS
+#define AC_CONTROLLER_PERIOD_TIMEOUTS AC_CONTROLLER_CONF_PERIOD_TIMEOUTS
+#else
+#define AC_CONTROLLER_PERIOD_TIMEOUTS 8
+#endif
+
+/* These are the policies a zone can use to decide on its AC state. */
+enum {
+  /* ON as soon as one sensor is hot, OFF when all of them are cool. */
+  AC_POLICY_MAX,
+  /* ON when at least ->quorum sensors are hot. */
+  AC_POLICY_QUORUM,
+  /* ON when the weighted average temperature crosses ON_TEMP, OFF when
+     it drops below OFF_TEMP. */
+  AC_POLICY_WEIGHTED_AVG
+};
+
+/* This structure holds the latest state of one sensor. */
+struct ac_sensor {
+  linkaddr_t addr;
+  uint8_t temp;
+  /* Moving average of the difference between consecutive readings, in
+     1/16 degree units. */
+  int8_t trend;
+  uint8_t zone;
+  uint8_t weight;
+  uint8_t flags;
+  /* The report period announced by the sensor in seconds, or 0. */
+  uint8_t period;
+  uint16_t last_seen;
+};
+
+/* This structure holds the aggregate state of a zone. All fields are
+   updated incrementally as readings arrive. */
+struct ac_zone {
+  uint8_t policy;
+  uint8_t quorum;
+  uint8_t members;
+  uint8_t hot;
+  uint16_t weight_sum;
+  uint32_t temp_sum;
+};
+
+/* Maps a sensor to a zone. A weight of 0 is treated as 1. */
+struct ac_zone_map {
+  linkaddr_t addr;
+  uint8_t zone;
+  uint8_t weight;
+};
+
+struct ac_controller_callbacks {
+  /* Called whenever the AC decision of a zone changes. */
+  void (*changed)(uint8_t zone, uint8_t on);
+};
+
+/* Initialize the controller. The map may be NULL, in which case all
+   sensors go into zone 0 with weight 1. */
+void ac_controller_init(const struct ac_controller_callbacks *callbacks,
+                        const struct ac_zone_map *map, uint8_t map_len);
+
+/* Set the decision policy of a zone. */
+void ac_controller_set_policy(uint8_t zone, uint8_t policy, uint8_t quorum);
+
+/* Feed a new reading from a sensor into the controller, along with its
+   report period in seconds, or 0 if it did not announce one. */
+void ac_controller_update(const linkaddr_t *from, uint8_t temp,
+                          uint8_t period);
+
+/* Set the number of receivers the sensors share their readings
+   among, this one included. The default is 1. */
+void ac_controller_set_receivers(uint8_t receivers);
+
+/* Drop sensors that have not reported within their timeout. */
+void ac_controller_expire(void);
+
+/* Look up the state of a sensor, or NULL if it is not known. */
+const struct ac_sensor *ac_controller_sensor(const linkaddr_t *addr);
+
+/* Return the zone state as a bitmask, one bit per zone. */
+uint8_t ac_controller_state(void);
+
+#endif /* AC_CONTROLLER_H_ */
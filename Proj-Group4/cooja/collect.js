@@ -0,0 +1,144 @@
+/*
+ * KPI collector for the benchmark scenarios, run by the ScriptRunner
+ * plugin. It follows the firmware log output and, once the simulated
+ * time in the scenario title has passed, writes one CSV line to
+ * <scenario>.csv and appends it to summary.csv in the working directory.
+ *
+ *  pdr                 readings received by a receiver / readings sent,
+ *                      counting each reading once by its number even if
+ *                      it was retried
+ *  ac_latency          time from the first hot reading sent to a receiver
+ *                      until that receiver switches its zone AC on
+ *  neighbor_convergence time until every sender knows a receiver, from a
+ *                      beacon or an advert
+ *  radio_duty_cycle    average radio on time, from PowerTracker
+ */
+TIMEOUT(7200000, log.log("collect.js: simulation did not finish\n"); log.testFailed());
+
+var HOT = 70;
+var title = sim.getTitle().split(" ");
+var name = title[0];
+var duration = (title.length > 1 ? parseInt(title[1]) : 600) * 1000000;
+
+var motes = sim.getMotes();
+var nsenders = 0, nreceivers = 0;
+for(var i = 0; i < motes.length; i++) {
+  if(motes[i].getType().getIdentifier() == "sender") {
+    nsenders++;
+  } else {
+    nreceivers++;
+  }
+}
+
+var sent = 0, received = 0;
+var last_sent = {}, last_received = {};
+var hot_pending = {}, ac_on = {};
+var latencies = [];
+var first_neighbor = {}, nconverged = 0, converged = -1;
+var done = false;
+
+function collect() {
+  var sum = 0, max = 0;
+  for(var i = 0; i < latencies.length; i++) {
+    sum += latencies[i];
+    max = Math.max(max, latencies[i]);
+  }
+
+  var duty = "";
+  var plugin = sim.getCooja().getStartedPlugin("PowerTracker");
+  if(plugin != null) {
+    var lines = String(plugin.radioStatistics()).split("\n");
+    var total = 0, n = 0;
+    for(var i = 0; i < lines.length; i++) {
+      var m = lines[i].match(/\bON\b.*?([0-9.]+)\s*%/);
+      if(m == null) {
+        continue;
+      }
+      if(lines[i].indexOf("AVERAGE") == 0) {
+        total = parseFloat(m[1]);
+        n = 1;
+        break;
+      }
+      total += parseFloat(m[1]);
+      n++;
+    }
+    if(n > 0) {
+      duty = (total / n).toFixed(2);
+    }
+  }
+
+  var header = "scenario,motes,receivers,sim_seconds,readings_sent," +
+    "readings_received,pdr,ac_commands,ac_latency_ms_avg,ac_latency_ms_max," +
+    "neighbor_convergence_ms,radio_duty_cycle_pct";
+  var line = [name, motes.length, nreceivers, duration / 1000000,
+              sent, received,
+              sent > 0 ? (received / sent).toFixed(4) : "",
+              latencies.length,
+              latencies.length > 0 ? (sum / latencies.length / 1000).toFixed(1) : "",
+              latencies.length > 0 ? (max / 1000).toFixed(1) : "",
+              converged >= 0 ? (converged / 1000).toFixed(1) : "",
+              duty].join(",");
+
+  var out = new java.io.FileWriter(name + ".csv");
+  out.write(header + "\n" + line + "\n");
+  out.close();
+
+  var summary = new java.io.File("summary.csv");
+  var exists = summary.exists();
+  out = new java.io.FileWriter(summary, true);
+  if(!exists) {
+    out.write(header + "\n");
+  }
+  out.write(line + "\n");
+  out.close();
+
+  log.log(header + "\n" + line + "\n");
+}
+
+while(true) {
+  var m;
+
+  if(time >= duration && !done) {
+    done = true;
+    collect();
+    log.testOK();
+  }
+
+  if((m = msg.match(
+        /^Sending unicast to (\d+) -> Temp = (\d+), reading (\d+)/)) != null) {
+    /* A retry goes out within the PONG timeout and keeps the number. */
+    if(last_sent[id] != m[3]) {
+      last_sent[id] = m[3];
+      sent++;
+    }
+    if(parseInt(m[2]) > HOT && !ac_on[m[1]] && hot_pending[m[1]] == null) {
+      hot_pending[m[1]] = time;
+    }
+  } else if((m = msg.match(
+        /^Unicast received from (\d+) -> TEMP = \d+, reading (\d+)/)) != null) {
+    /* The retry may reach another receiver, so count by sender. */
+    if(last_received[m[1]] != m[2]) {
+      last_received[m[1]] = m[2];
+      received++;
+    }
+  } else if((m = msg.match(/^Zone \d+ AC (ON|OFF)/)) != null) {
+    if(m[1] == "ON") {
+      ac_on[id] = true;
+      if(hot_pending[id] != null) {
+        latencies.push(time - hot_pending[id]);
+      }
+    } else {
+      ac_on[id] = false;
+    }
+    hot_pending[id] = null;
+  } else if(msg.match(/^(Broadcast message|Advert) received from/) &&
+            mote.getType().getIdentifier() == "sender" &&
+            first_neighbor[id] == null) {
+    first_neighbor[id] = time;
+    if(++nconverged == nsenders) {
+      converged = time;
+    }
+  }
+
+  YIELD();
+}
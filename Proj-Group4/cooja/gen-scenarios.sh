@@ -0,0 +1,141 @@
+#!/bin/sh
+# Generate the headless Cooja benchmark scenarios.
+#
+#   ./gen-scenarios.sh [sizes] [sim seconds]
+#
+# For every size N this writes grid-N.csc and random-N.csc. Every
+# RECEIVER_RATIO-th mote (ids 1, 1 + RATIO, ...) runs receiver.c, the
+# others run sender.c. Motes are 30 m apart on the grid; the random
+# topology keeps the same density, with a fixed seed per size so the
+# layouts are reproducible.
+
+SIZES=${1:-"10 50 100 200"}
+SIM_SECONDS=${2:-600}
+RECEIVER_RATIO=${RECEIVER_RATIO:-10}
+SPACING=30
+TX_RANGE=50
+INT_RANGE=100
+
+header() {
+  cat <<EOT
+<?xml version="1.0" encoding="UTF-8"?>
+<simconf>
+  <simulation>
+    <title>$1</title>
+    <randomseed>$2</randomseed>
+    <motedelay_us>1000000</motedelay_us>
+    <radiomedium>
+      org.contikios.cooja.radiomediums.UDGM
+      <transmitting_range>$TX_RANGE.0</transmitting_range>
+      <interference_range>$INT_RANGE.0</interference_range>
+      <success_ratio_tx>1.0</success_ratio_tx>
+      <success_ratio_rx>1.0</success_ratio_rx>
+    </radiomedium>
+    <events>
+      <logoutput>40000</logoutput>
+    </events>
+EOT
+  motetype receiver Receiver
+  motetype sender Sender
+}
+
+motetype() {
+  cat <<EOT
+    <motetype>
+      org.contikios.cooja.contikimote.ContikiMoteType
+      <identifier>$1</identifier>
+      <description>$2</description>
+      <source>[CONFIG_DIR]/../$1.c</source>
+      <commands>make $1.cooja TARGET=cooja</commands>
+      <moteinterface>org.contikios.cooja.interfaces.Position</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Battery</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiMoteID</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiRS232</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.RimeAddress</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiRadio</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiClock</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiLED</moteinterface>
+      <moteinterface>org.contikios.cooja.contikimote.interfaces.ContikiCFS</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.Mote2MoteRelations</moteinterface>
+      <moteinterface>org.contikios.cooja.interfaces.MoteAttributes</moteinterface>
+      <symbols>false</symbols>
+    </motetype>
+EOT
+}
+
+# Print one "id x y" line per mote.
+positions() {
+  awk -v n="$2" -v s="$SPACING" -v seed="$n" -v topo="$1" 'BEGIN {
+    side = int(sqrt(n));
+    if(side * side < n) side++;
+    srand(seed);
+    for(i = 0; i < n; i++) {
+      if(topo == "grid") {
+        x = (i % side) * s; y = int(i / side) * s;
+      } else {
+        x = rand() * (side - 1) * s; y = rand() * (side - 1) * s;
+      }
+      printf "%d %.1f %.1f\n", i + 1, x, y;
+    }
+  }'
+}
+
+footer() {
+  cat <<EOT
+  </simulation>
+  <plugin>
+    org.contikios.cooja.plugins.PowerTracker
+    <width>400</width>
+    <z>0</z>
+    <height>400</height>
+    <location_x>0</location_x>
+    <location_y>0</location_y>
+  </plugin>
+  <plugin>
+    org.contikios.cooja.plugins.ScriptRunner
+    <plugin_config>
+      <scriptfile>[CONFIG_DIR]/collect.js</scriptfile>
+      <active>true</active>
+    </plugin_config>
+    <width>600</width>
+    <z>1</z>
+    <height>400</height>
+    <location_x>400</location_x>
+    <location_y>0</location_y>
+  </plugin>
+</simconf>
+EOT
+}
+
+for n in $SIZES; do
+  for topo in grid random; do
+    name=$topo-$n
+    {
+      header "$name $SIM_SECONDS" "$n"
+      positions $topo $n | while read id x y; do
+        if [ $(( (id - 1) % RECEIVER_RATIO )) -eq 0 ]; then
+          type=receiver
+        else
+          type=sender
+        fi
+        cat <<EOT
+    <mote>
+      <interface_config>
+        org.contikios.cooja.interfaces.Position
+        <x>$x</x>
+        <y>$y</y>
+        <z>0.0</z>
+      </interface_config>
+      <interface_config>
+        org.contikios.cooja.contikimote.interfaces.ContikiMoteID
+        <id>$id</id>
+      </interface_config>
+      <motetype_identifier>$type</motetype_identifier>
+    </mote>
+EOT
+      done
+      footer
+    } > $name.csc
+    echo "Wrote $name.csc"
+  done
+done
@@ -0,0 +1,125 @@
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "frame-trace.h"
+#include "task-sched.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/* The largest record header: flags, a long time, addr and len. */
+#define RECORD_HEADER_MAX 8
+
+static uint8_t buffer[FRAME_TRACE_BUFFER];
+static uint8_t used;
+
+static struct sched_task flush_task;
+
+static clock_time_t last_time;
+static int32_t size;
+static uint8_t started;
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+put_le(uint8_t *p, uint32_t v, uint8_t n)
+{
+  uint8_t i;
+
+  for(i = 0; i < n; i++) {
+    p[i] = v >> (8 * i);
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+flush(void *ptr)
+{
+  int fd;
+
+  if(used == 0) {
+    return;
+  }
+  fd = cfs_open(FRAME_TRACE_FILE, CFS_WRITE | CFS_APPEND);
+  if(fd < 0 || cfs_write(fd, buffer, used) != used) {
+    printf("Frame trace: write failed\n");
+  }
+  if(fd >= 0) {
+    cfs_close(fd);
+  }
+  used = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+frame_trace_init(uint8_t role)
+{
+  cfs_remove(FRAME_TRACE_FILE);
+  used = 0;
+  last_time = 0;
+  buffer[used++] = 'F';
+  buffer[used++] = 'T';
+  buffer[used++] = FRAME_TRACE_VERSION;
+  buffer[used++] = role;
+  memcpy(&buffer[used], &linkaddr_node_addr, sizeof(linkaddr_t));
+  used += sizeof(linkaddr_t);
+  size = used;
+  started = 1;
+  flush(NULL);
+}
+/*---------------------------------------------------------------------------*/
+void
+frame_trace_record(uint8_t flags, const linkaddr_t *addr,
+                   const void *data, uint8_t len)
+{
+  clock_time_t now, delta;
+  uint8_t *p;
+
+  if(!started) {
+    return;
+  }
+  /* A frame that does not fit ends the trace, so that a replay never
+     runs past a hole in it. */
+  if(size + RECORD_HEADER_MAX + len > FRAME_TRACE_MAX_SIZE ||
+     RECORD_HEADER_MAX + len > sizeof(buffer)) {
+    printf("Frame trace: %s, recording stopped\n",
+           RECORD_HEADER_MAX + len > sizeof(buffer) ?
+           "frame too long" : "full");
+    started = 0;
+    frame_trace_flush();
+    return;
+  }
+  if(used + RECORD_HEADER_MAX + len > sizeof(buffer)) {
+    flush(NULL);
+  }
+
+  now = clock_time();
+  delta = now - last_time;
+  last_time = now;
+
+  p = &buffer[used];
+  if(delta > 0xffff) {
+    *p++ = flags | FRAME_TRACE_LONG;
+    p += put_le(p, now, 4);
+  } else {
+    *p++ = flags;
+    p += put_le(p, delta, 2);
+  }
+  memcpy(p, addr != NULL ? addr : &linkaddr_null, sizeof(linkaddr_t));
+  p += sizeof(linkaddr_t);
+  *p++ = len;
+  memcpy(p, data, len);
+  p += len;
+
+  size += p - &buffer[used];
+  used = p - buffer;
+  if(!sched_pending(&flush_task)) {
+    sched_set(&flush_task, FRAME_TRACE_FLUSH / 2, FRAME_TRACE_FLUSH,
+              flush, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+frame_trace_flush(void)
+{
+  sched_stop(&flush_task);
+  flush(NULL);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,67 @@
+#ifndef FRAME_TRACE_H_
+#define FRAME_TRACE_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+/* A frame trace records every frame a node receives and sends, so that
+   its traffic can be replayed on the host by native/replay.c. The trace
+   is written to FRAME_TRACE_FILE, which is started over at boot.
+
+   It begins with a header of FRAME_TRACE_HEADER_LEN bytes: the magic
+   "FT", the format version, the role of the node and its address.
+   Every frame follows as a record of
+
+     flags   FRAME_TRACE_TX, FRAME_TRACE_UNICAST, FRAME_TRACE_LONG
+     time    ticks since the previous record, 2 bytes, or since boot,
+             4 bytes with FRAME_TRACE_LONG
+     addr    the sender of a received frame, the receiver of a sent
+             one, or linkaddr_null for a sent broadcast
+     len     1 byte
+     payload len bytes
+
+   with all numbers little endian. The broadcast and unicast channels
+   are those of node.h. */
+#define FRAME_TRACE_VERSION 1
+#define FRAME_TRACE_HEADER_LEN 6
+
+#define FRAME_TRACE_TX      0x01
+#define FRAME_TRACE_UNICAST 0x02
+#define FRAME_TRACE_LONG    0x04
+
+#ifdef FRAME_TRACE_CONF_FILE
+#define FRAME_TRACE_FILE FRAME_TRACE_CONF_FILE
+#else
+#define FRAME_TRACE_FILE "frames.trace"
+#endif
+
+/* Recording stops once the trace reaches this size, or at the first
+   frame that does not fit in the buffer below. */
+#ifdef FRAME_TRACE_CONF_MAX_SIZE
+#define FRAME_TRACE_MAX_SIZE FRAME_TRACE_CONF_MAX_SIZE
+#else
+#define FRAME_TRACE_MAX_SIZE 32768L
+#endif
+
+/* Records are collected in a RAM buffer of this size, at most 255
+   bytes, which is written out when it is full or FRAME_TRACE_FLUSH
+   after its first record. */
+#ifdef FRAME_TRACE_CONF_BUFFER
+#define FRAME_TRACE_BUFFER FRAME_TRACE_CONF_BUFFER
+#else
+#define FRAME_TRACE_BUFFER 128
+#endif
+
+#define FRAME_TRACE_FLUSH (10 * CLOCK_SECOND)
+
+/* Start a new trace for a node of the given role. */
+void frame_trace_init(uint8_t role);
+
+/* Record a frame. flags are FRAME_TRACE_TX and FRAME_TRACE_UNICAST. */
+void frame_trace_record(uint8_t flags, const linkaddr_t *addr,
+                        const void *data, uint8_t len);
+
+/* Write out the buffered records. */
+void frame_trace_flush(void);
+
+#endif /* FRAME_TRACE_H_ */
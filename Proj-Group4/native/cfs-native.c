@@ -0,0 +1,80 @@
+/*
+ * CFS on top of POSIX files, and the CRC16 used with it.
+ */
+#include "cfs/cfs.h"
+#include "lib/crc16.h"
+
+#include <fcntl.h>
+#include <unistd.h>
+
+/*---------------------------------------------------------------------------*/
+int
+cfs_open(const char *name, int flags)
+{
+  int f;
+
+  if(flags == CFS_READ) {
+    f = O_RDONLY;
+  } else {
+    f = O_CREAT | ((flags & CFS_READ) ? O_RDWR : O_WRONLY);
+    if(flags & CFS_APPEND) {
+      f |= O_APPEND;
+    }
+  }
+  return open(name, f, 0600);
+}
+/*---------------------------------------------------------------------------*/
+void
+cfs_close(int fd)
+{
+  close(fd);
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_read(int fd, void *buf, unsigned int len)
+{
+  return read(fd, buf, len);
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_write(int fd, const void *buf, unsigned int len)
+{
+  return write(fd, buf, len);
+}
+/*---------------------------------------------------------------------------*/
+cfs_offset_t
+cfs_seek(int fd, cfs_offset_t offset, int whence)
+{
+  return lseek(fd, offset, whence == CFS_SEEK_SET ? SEEK_SET :
+               (whence == CFS_SEEK_CUR ? SEEK_CUR : SEEK_END));
+}
+/*---------------------------------------------------------------------------*/
+int
+cfs_remove(const char *name)
+{
+  return unlink(name);
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+crc16_add(unsigned char b, unsigned short acc)
+{
+  acc ^= b;
+  acc = (acc >> 8) | (acc << 8);
+  acc ^= (acc & 0xff00) << 4;
+  acc ^= (acc >> 8) >> 4;
+  acc ^= (acc & 0xff00) >> 5;
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+crc16_data(const unsigned char *data, int len, unsigned short acc)
+{
+  int i;
+
+  for(i = 0; i < len; ++i) {
+    acc = crc16_add(*data, acc);
+    ++data;
+  }
+  return acc;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,606 @@
+/*
+ * Host implementation of the Contiki services declared in include/.
+ * Everything is single threaded and driven by native_run(), which
+ * advances a virtual clock and fires timers in expiry order.
+ */
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "dev/leds.h"
+
+#include <string.h>
+
+#define MAX_EVENTS 64
+
+static clock_time_t now;
+
+struct process *process_current;
+static struct process *process_list;
+
+struct event_data {
+  process_event_t ev;
+  process_data_t data;
+  struct process *p;
+};
+static struct event_data events[MAX_EVENTS];
+static unsigned nevents, fevent;
+static process_event_t lastevent = PROCESS_EVENT_TIMER + 1;
+
+static struct etimer *etimer_list;
+static struct ctimer *ctimer_list;
+
+linkaddr_t linkaddr_node_addr;
+const linkaddr_t linkaddr_null;
+
+static unsigned char leds;
+static unsigned short rand_state = 1;
+
+/*---------------------------------------------------------------------------*/
+clock_time_t
+clock_time(void)
+{
+  return now;
+}
+/*---------------------------------------------------------------------------*/
+unsigned long
+clock_seconds(void)
+{
+  return now / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_set(struct timer *t, clock_time_t interval)
+{
+  t->interval = interval;
+  t->start = now;
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_reset(struct timer *t)
+{
+  t->start += t->interval;
+}
+/*---------------------------------------------------------------------------*/
+void
+timer_restart(struct timer *t)
+{
+  t->start = now;
+}
+/*---------------------------------------------------------------------------*/
+int
+timer_expired(struct timer *t)
+{
+  return now - t->start >= t->interval;
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+timer_remaining(struct timer *t)
+{
+  return t->start + t->interval - now;
+}
+/*---------------------------------------------------------------------------*/
+static void
+call_process(struct process *p, process_event_t ev, process_data_t data)
+{
+  struct process *caller;
+  struct process **pp;
+  char ret;
+
+  if(p->state == 0) {
+    return;
+  }
+  caller = process_current;
+  process_current = p;
+  ret = p->thread(&p->pt, ev, data);
+  if(ret == PT_EXITED || ret == PT_ENDED || ev == PROCESS_EVENT_EXIT) {
+    p->state = 0;
+    for(pp = &process_list; *pp != NULL; pp = &(*pp)->next) {
+      if(*pp == p) {
+        *pp = p->next;
+        break;
+      }
+    }
+  }
+  process_current = caller;
+}
+/*---------------------------------------------------------------------------*/
+void
+process_start(struct process *p, process_data_t data)
+{
+  if(p->state != 0) {
+    return;
+  }
+  p->next = process_list;
+  process_list = p;
+  p->state = 1;
+  p->needspoll = 0;
+  PT_INIT(&p->pt);
+  call_process(p, PROCESS_EVENT_INIT, data);
+}
+/*---------------------------------------------------------------------------*/
+void
+process_exit(struct process *p)
+{
+  call_process(p, PROCESS_EVENT_EXIT, NULL);
+}
+/*---------------------------------------------------------------------------*/
+int
+process_is_running(struct process *p)
+{
+  return p->state != 0;
+}
+/*---------------------------------------------------------------------------*/
+process_event_t
+process_alloc_event(void)
+{
+  return lastevent++;
+}
+/*---------------------------------------------------------------------------*/
+int
+process_post(struct process *p, process_event_t ev, process_data_t data)
+{
+  unsigned i;
+
+  if(nevents == MAX_EVENTS) {
+    return 1;
+  }
+  i = (fevent + nevents) % MAX_EVENTS;
+  events[i].ev = ev;
+  events[i].data = data;
+  events[i].p = p;
+  nevents++;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+process_post_synch(struct process *p, process_event_t ev, process_data_t data)
+{
+  call_process(p, ev, data);
+}
+/*---------------------------------------------------------------------------*/
+void
+process_poll(struct process *p)
+{
+  if(p != NULL && p->state != 0) {
+    p->needspoll = 1;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+process_run_all(void)
+{
+  struct process *p, *next;
+  struct event_data e;
+  int polled;
+
+  do {
+    polled = 0;
+    for(p = process_list; p != NULL; p = next) {
+      next = p->next;
+      if(p->needspoll) {
+        p->needspoll = 0;
+        polled = 1;
+        call_process(p, PROCESS_EVENT_POLL, NULL);
+      }
+    }
+    if(nevents > 0) {
+      e = events[fevent];
+      fevent = (fevent + 1) % MAX_EVENTS;
+      nevents--;
+      if(e.p == PROCESS_BROADCAST) {
+        for(p = process_list; p != NULL; p = next) {
+          next = p->next;
+          call_process(p, e.ev, e.data);
+        }
+      } else {
+        call_process(e.p, e.ev, e.data);
+      }
+    }
+  } while(polled || nevents > 0);
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_set(struct etimer *et, clock_time_t interval)
+{
+  timer_set(&et->timer, interval);
+  etimer_restart(et);
+}
+/*---------------------------------------------------------------------------*/
+static void
+etimer_add(struct etimer *et)
+{
+  struct etimer *t;
+
+  et->p = PROCESS_CURRENT();
+  for(t = etimer_list; t != NULL; t = t->next) {
+    if(t == et) {
+      return;
+    }
+  }
+  et->next = etimer_list;
+  etimer_list = et;
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_reset(struct etimer *et)
+{
+  timer_reset(&et->timer);
+  etimer_add(et);
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_restart(struct etimer *et)
+{
+  timer_restart(&et->timer);
+  etimer_add(et);
+}
+/*---------------------------------------------------------------------------*/
+void
+etimer_stop(struct etimer *et)
+{
+  struct etimer **t;
+
+  for(t = &etimer_list; *t != NULL; t = &(*t)->next) {
+    if(*t == et) {
+      *t = et->next;
+      break;
+    }
+  }
+  et->p = PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+int
+etimer_expired(struct etimer *et)
+{
+  return et->p == PROCESS_NONE;
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+etimer_expiration_time(struct etimer *et)
+{
+  return et->timer.start + et->timer.interval;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_set(struct ctimer *c, clock_time_t t, void (*f)(void *), void *ptr)
+{
+  c->f = f;
+  c->ptr = ptr;
+  timer_set(&c->timer, t);
+  ctimer_restart(c);
+}
+/*---------------------------------------------------------------------------*/
+static void
+ctimer_add(struct ctimer *c)
+{
+  struct ctimer *t;
+
+  c->active = 1;
+  c->p = PROCESS_CURRENT();
+  for(t = ctimer_list; t != NULL; t = t->next) {
+    if(t == c) {
+      return;
+    }
+  }
+  c->next = ctimer_list;
+  ctimer_list = c;
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_reset(struct ctimer *c)
+{
+  timer_reset(&c->timer);
+  ctimer_add(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_restart(struct ctimer *c)
+{
+  timer_restart(&c->timer);
+  ctimer_add(c);
+}
+/*---------------------------------------------------------------------------*/
+void
+ctimer_stop(struct ctimer *c)
+{
+  struct ctimer **t;
+
+  for(t = &ctimer_list; *t != NULL; t = &(*t)->next) {
+    if(*t == c) {
+      *t = c->next;
+      break;
+    }
+  }
+  c->active = 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+ctimer_expired(struct ctimer *c)
+{
+  return !c->active;
+}
+/*---------------------------------------------------------------------------*/
+void
+native_run(clock_time_t t)
+{
+  struct etimer *et, *first_et;
+  struct ctimer *ct, *first_ct;
+  struct process *owner, *caller;
+  clock_time_t expiry, first;
+
+  process_run_all();
+  while(1) {
+    first_et = NULL;
+    first_ct = NULL;
+    first = t;
+    for(et = etimer_list; et != NULL; et = et->next) {
+      expiry = etimer_expiration_time(et);
+      if((long)(expiry - first) <= 0) {
+        first = expiry;
+        first_et = et;
+      }
+    }
+    for(ct = ctimer_list; ct != NULL; ct = ct->next) {
+      expiry = ct->timer.start + ct->timer.interval;
+      if((long)(expiry - first) < 0 ||
+         ((long)(expiry - first) == 0 && first_et == NULL)) {
+        first = expiry;
+        first_ct = ct;
+        first_et = NULL;
+      }
+    }
+    if(first_et == NULL && first_ct == NULL) {
+      break;
+    }
+    if((long)(first - now) > 0) {
+      now = first;
+    }
+    if(first_ct != NULL) {
+      ctimer_stop(first_ct);
+      caller = process_current;
+      process_current = first_ct->p;
+      first_ct->f(first_ct->ptr);
+      process_current = caller;
+    } else {
+      owner = first_et->p;
+      etimer_stop(first_et);
+      process_post(owner, PROCESS_EVENT_TIMER, first_et);
+    }
+    process_run_all();
+  }
+  if((long)(t - now) > 0) {
+    now = t;
+  }
+  process_run_all();
+}
+/*---------------------------------------------------------------------------*/
+void
+native_autostart(void)
+{
+  extern struct process * const autostart_processes[];
+  int i;
+
+  for(i = 0; autostart_processes[i] != NULL; i++) {
+    process_start(autostart_processes[i], NULL);
+  }
+  process_run_all();
+}
+/*---------------------------------------------------------------------------*/
+void
+list_init(list_t list)
+{
+  *list = NULL;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_head(list_t list)
+{
+  return *list;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_tail(list_t list)
+{
+  struct list { struct list *next; } *l;
+
+  if(*list == NULL) {
+    return NULL;
+  }
+  for(l = *list; l->next != NULL; l = l->next);
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+void
+list_remove(list_t list, void *item)
+{
+  struct list { struct list *next; } **l;
+
+  for(l = (struct list **)list; *l != NULL; l = &(*l)->next) {
+    if(*l == item) {
+      *l = (*l)->next;
+      return;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+list_add(list_t list, void *item)
+{
+  struct list { struct list *next; } *l;
+
+  list_remove(list, item);
+  ((struct list *)item)->next = NULL;
+  l = list_tail(list);
+  if(l == NULL) {
+    *list = item;
+  } else {
+    l->next = item;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+list_push(list_t list, void *item)
+{
+  struct list { struct list *next; } *l = item;
+
+  list_remove(list, item);
+  l->next = *list;
+  *list = l;
+}
+/*---------------------------------------------------------------------------*/
+void
+list_insert(list_t list, void *previtem, void *newitem)
+{
+  struct list { struct list *next; } *p = previtem, *n = newitem;
+
+  if(p == NULL) {
+    list_push(list, newitem);
+  } else {
+    list_remove(list, newitem);
+    n->next = p->next;
+    p->next = n;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_pop(list_t list)
+{
+  struct list { struct list *next; } *l = *list;
+
+  if(l != NULL) {
+    *list = l->next;
+  }
+  return l;
+}
+/*---------------------------------------------------------------------------*/
+int
+list_length(list_t list)
+{
+  struct list { struct list *next; } *l;
+  int n = 0;
+
+  for(l = *list; l != NULL; l = l->next) {
+    n++;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void *
+list_item_next(void *item)
+{
+  return item == NULL ? NULL : ((struct { void *next; } *)item)->next;
+}
+/*---------------------------------------------------------------------------*/
+void
+memb_init(struct memb *m)
+{
+  memset(m->count, 0, m->num);
+  memset(m->mem, 0, (size_t)m->size * m->num);
+}
+/*---------------------------------------------------------------------------*/
+void *
+memb_alloc(struct memb *m)
+{
+  int i;
+
+  for(i = 0; i < m->num; i++) {
+    if(m->count[i] == 0) {
+      m->count[i] = 1;
+      return (char *)m->mem + i * m->size;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+int
+memb_inmemb(struct memb *m, void *ptr)
+{
+  return (char *)ptr >= (char *)m->mem &&
+    (char *)ptr < (char *)m->mem + m->num * m->size;
+}
+/*---------------------------------------------------------------------------*/
+char
+memb_free(struct memb *m, void *ptr)
+{
+  int i;
+
+  if(!memb_inmemb(m, ptr)) {
+    return -1;
+  }
+  i = ((char *)ptr - (char *)m->mem) / m->size;
+  m->count[i] = 0;
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+memb_numfree(struct memb *m)
+{
+  int i, n = 0;
+
+  for(i = 0; i < m->num; i++) {
+    if(m->count[i] == 0) {
+      n++;
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+random_init(unsigned short seed)
+{
+  rand_state = seed ? seed : 1;
+}
+/*---------------------------------------------------------------------------*/
+unsigned short
+random_rand(void)
+{
+  /* 16 bit xorshift, deterministic for a given seed. */
+  rand_state ^= rand_state << 7;
+  rand_state ^= rand_state >> 9;
+  rand_state ^= rand_state << 8;
+  return rand_state;
+}
+/*---------------------------------------------------------------------------*/
+void
+leds_on(unsigned char l)
+{
+  leds |= l;
+}
+/*---------------------------------------------------------------------------*/
+void
+leds_off(unsigned char l)
+{
+  leds &= ~l;
+}
+/*---------------------------------------------------------------------------*/
+void
+leds_toggle(unsigned char l)
+{
+  leds ^= l;
+}
+/*---------------------------------------------------------------------------*/
+unsigned char
+leds_get(void)
+{
+  return leds;
+}
+/*---------------------------------------------------------------------------*/
+void
+linkaddr_copy(linkaddr_t *dest, const linkaddr_t *from)
+{
+  memcpy(dest, from, LINKADDR_SIZE);
+}
+/*---------------------------------------------------------------------------*/
+int
+linkaddr_cmp(const linkaddr_t *addr1, const linkaddr_t *addr2)
+{
+  return memcmp(addr1, addr2, LINKADDR_SIZE) == 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+linkaddr_set_node_addr(linkaddr_t *addr)
+{
+  linkaddr_copy(&linkaddr_node_addr, addr);
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,27 @@
+/*
+ * Minimal stand-in for the parts of Contiki the Proj-Group4 firmware
+ * uses, so that it can be built and driven on the host. Processes,
+ * etimers and ctimers run off a virtual clock that the harness advances
+ * with native_run().
+ */
+#ifndef CONTIKI_H_
+#define CONTIKI_H_
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "pt.h"
+#include "sys/clock.h"
+#include "sys/process.h"
+#include "sys/etimer.h"
+#include "sys/ctimer.h"
+#include "net/linkaddr.h"
+
+/* Run every process timer and callback timer that expires up to and
+   including the virtual time t, then leave the clock at t. */
+void native_run(clock_time_t t);
+
+/* Start the processes listed by AUTOSTART_PROCESSES(). */
+void native_autostart(void);
+
+#endif /* CONTIKI_H_ */
@@ -0,0 +1,24 @@
+#ifndef MEMB_H_
+#define MEMB_H_
+
+#define MEMB(name, structure, num) \
+  static char name##_memb_count[num]; \
+  static structure name##_memb_mem[num]; \
+  static struct memb name = {sizeof(structure), num, \
+                             name##_memb_count, \
+                             (void *)name##_memb_mem}
+
+struct memb {
+  unsigned short size;
+  unsigned short num;
+  char *count;
+  void *mem;
+};
+
+void memb_init(struct memb *m);
+void *memb_alloc(struct memb *m);
+char memb_free(struct memb *m, void *ptr);
+int memb_inmemb(struct memb *m, void *ptr);
+int memb_numfree(struct memb *m);
+
+#endif /* MEMB_H_ */
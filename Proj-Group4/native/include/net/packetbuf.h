@@ -0,0 +1,15 @@
+#ifndef PACKETBUF_H_
+#define PACKETBUF_H_
+
+#include <stdint.h>
+
+#define PACKETBUF_SIZE 128
+
+void packetbuf_clear(void);
+void *packetbuf_dataptr(void);
+uint16_t packetbuf_datalen(void);
+void packetbuf_set_datalen(uint16_t len);
+int packetbuf_copyfrom(const void *from, uint16_t len);
+int packetbuf_copyto(void *to);
+
+#endif /* PACKETBUF_H_ */
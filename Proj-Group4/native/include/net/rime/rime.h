@@ -0,0 +1,56 @@
+/*
+ * Stubbed Rime layer. Opened connections are kept in a table by
+ * channel; frames are injected with native_rime_input() and outgoing
+ * frames are handed to the native_rime_output hook instead of a radio.
+ */
+#ifndef RIME_H_
+#define RIME_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+#include "net/packetbuf.h"
+
+struct broadcast_conn;
+struct unicast_conn;
+
+struct broadcast_callbacks {
+  void (* recv)(struct broadcast_conn *ptr, const linkaddr_t *sender);
+  void (* sent)(struct broadcast_conn *ptr, int status, int num_tx);
+};
+
+struct unicast_callbacks {
+  void (* recv)(struct unicast_conn *c, const linkaddr_t *from);
+  void (* sent)(struct unicast_conn *ptr, int status, int num_tx);
+};
+
+struct broadcast_conn {
+  uint16_t channel;
+  const struct broadcast_callbacks *u;
+};
+
+struct unicast_conn {
+  struct broadcast_conn c;
+  const struct unicast_callbacks *u;
+};
+
+void broadcast_open(struct broadcast_conn *c, uint16_t channel,
+                    const struct broadcast_callbacks *u);
+void broadcast_close(struct broadcast_conn *c);
+int broadcast_send(struct broadcast_conn *c);
+
+void unicast_open(struct unicast_conn *c, uint16_t channel,
+                  const struct unicast_callbacks *u);
+void unicast_close(struct unicast_conn *c);
+int unicast_send(struct unicast_conn *c, const linkaddr_t *receiver);
+
+/* Deliver a frame to the connection open on the channel. A NULL
+   destination means a broadcast. Returns 0 if nothing listens on it. */
+int native_rime_input(uint16_t channel, const linkaddr_t *from,
+                      const linkaddr_t *to, const void *data, int len);
+
+/* Called for every frame the firmware sends. A NULL destination means
+   a broadcast. */
+extern void (* native_rime_output)(uint16_t channel, const linkaddr_t *to,
+                                   const void *data, int len);
+
+#endif /* RIME_H_ */
@@ -0,0 +1,12 @@
+#ifndef CLOCK_H_
+#define CLOCK_H_
+
+/* Same tick rate as the MicaZ port. */
+#define CLOCK_SECOND 128
+
+typedef unsigned long clock_time_t;
+
+clock_time_t clock_time(void);
+unsigned long clock_seconds(void);
+
+#endif /* CLOCK_H_ */
@@ -0,0 +1,23 @@
+#ifndef CTIMER_H_
+#define CTIMER_H_
+
+#include "sys/timer.h"
+#include "sys/process.h"
+
+struct ctimer {
+  struct ctimer *next;
+  struct timer timer;
+  struct process *p;
+  void (*f)(void *);
+  void *ptr;
+  unsigned char active;
+};
+
+void ctimer_set(struct ctimer *c, clock_time_t t,
+                void (*f)(void *), void *ptr);
+void ctimer_reset(struct ctimer *c);
+void ctimer_restart(struct ctimer *c);
+void ctimer_stop(struct ctimer *c);
+int ctimer_expired(struct ctimer *c);
+
+#endif /* CTIMER_H_ */
@@ -0,0 +1,341 @@
+/*
+ * Replay driver for frame traces recorded with make TRACE=1 (see
+ * ../frame-trace.h).
+ *
+ * The role firmware is compiled for the host against the stubbed
+ * Contiki and Rime layers in this directory, as replay-receiver or
+ * replay-sender, and takes the address of the node that recorded the
+ * trace. Every received frame of the trace is fed into it at its
+ * recorded time, in virtual time and as fast as possible, or with -r
+ * at the recorded speed. Every receive callback is timed on the host
+ * clock. The frames the firmware sends are compared, in order, with
+ * the frames the node sent when the trace was recorded.
+ *
+ * At the end the report lists the per-frame processing time, the
+ * neighbor table and, for the receiver, the AC decision of every zone
+ * and the state of every sensor in the trace.
+ *
+ *   ./replay-receiver [-r] [-v] trace
+ *   ./replay-sender [-r] [-v] trace
+ */
+#include "contiki.h"
+#include "net/rime/rime.h"
+#include "lib/list.h"
+#include "cfs/cfs.h"
+#include "node.h"
+#include "neighbor-table.h"
+#include "frame-trace.h"
+#if NODE_ROLE == NODE_ROLE_RECEIVER
+#include "ac-controller.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+struct frame {
+  clock_time_t time;
+  uint8_t flags;
+  linkaddr_t addr;
+  uint8_t len;
+  const uint8_t *data;
+};
+
+static FILE *report;
+
+static struct frame *trace;
+static unsigned long trace_len;
+
+/* The sent frames of the trace, and how far the replay matched them. */
+static unsigned long tx_sent, tx_next, tx_matched, tx_extra;
+static unsigned long tx_diverged = ~0UL;
+
+/*---------------------------------------------------------------------------*/
+static uint32_t
+get_le(const uint8_t *p, int n)
+{
+  uint32_t v;
+
+  for(v = 0; n > 0; n--) {
+    v = (v << 8) | p[n - 1];
+  }
+  return v;
+}
+/*---------------------------------------------------------------------------*/
+/* Read a trace into trace[]. Returns the header, or exits. */
+static const uint8_t *
+load(const char *name)
+{
+  static uint8_t *buf;
+  FILE *f;
+  long size, n;
+  const uint8_t *p, *end;
+  clock_time_t t;
+
+  f = fopen(name, "rb");
+  if(f == NULL || fseek(f, 0, SEEK_END) != 0 || (size = ftell(f)) < 0) {
+    fprintf(stderr, "cannot read %s\n", name);
+    exit(1);
+  }
+  rewind(f);
+  buf = malloc(size + 1);
+  trace = malloc((size / 6 + 1) * sizeof(struct frame));
+  if(buf == NULL || trace == NULL || fread(buf, 1, size, f) != (size_t)size) {
+    fprintf(stderr, "cannot read %s\n", name);
+    exit(1);
+  }
+  fclose(f);
+
+  if(size < FRAME_TRACE_HEADER_LEN || buf[0] != 'F' || buf[1] != 'T' ||
+     buf[2] != FRAME_TRACE_VERSION) {
+    fprintf(stderr, "%s is not a frame trace\n", name);
+    exit(1);
+  }
+  p = buf + FRAME_TRACE_HEADER_LEN;
+  end = buf + size;
+  t = 0;
+  for(n = 0; p < end; n++) {
+    if(p + ((*p & FRAME_TRACE_LONG) ? 8 : 6) > end) {
+      break;
+    }
+    trace[n].flags = *p;
+    if(*p & FRAME_TRACE_LONG) {
+      t = get_le(p + 1, 4);
+      p += 5;
+    } else {
+      t += get_le(p + 1, 2);
+      p += 3;
+    }
+    trace[n].time = t;
+    memcpy(&trace[n].addr, p, sizeof(linkaddr_t));
+    p += sizeof(linkaddr_t);
+    trace[n].len = *p++;
+    trace[n].data = p;
+    p += trace[n].len;
+    if(p > end) {
+      break;
+    }
+  }
+  if(p != end) {
+    fprintf(stderr, "%s: truncated after %ld frames\n", name, n);
+  }
+  trace_len = n;
+  return buf;
+}
+/*---------------------------------------------------------------------------*/
+/* Compare a frame sent by the firmware with the next sent frame of the
+   trace. */
+static void
+compare_output(uint16_t channel, const linkaddr_t *to, const void *data, int len)
+{
+  const struct frame *f;
+  uint8_t flags;
+
+  tx_sent++;
+  flags = FRAME_TRACE_TX | (to != NULL ? FRAME_TRACE_UNICAST : 0);
+  while(tx_next < trace_len && !(trace[tx_next].flags & FRAME_TRACE_TX)) {
+    tx_next++;
+  }
+  if(tx_next == trace_len) {
+    tx_extra++;
+    return;
+  }
+  f = &trace[tx_next++];
+  if((f->flags & ~FRAME_TRACE_LONG) == flags && f->len == len &&
+     (to == NULL || linkaddr_cmp(&f->addr, to)) &&
+     memcmp(f->data, data, len) == 0) {
+    tx_matched++;
+  } else if(tx_diverged == ~0UL) {
+    tx_diverged = f - trace;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmp_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static void
+print_neighbors(void)
+{
+  struct neighbor *n;
+
+  fprintf(report, "neighbors          %d\n", neighbor_table_length());
+  for(n = neighbor_table_head(); n != NULL; n = list_item_next(n)) {
+    fprintf(report, "  %d.%d  seqno %3u  missed %u  interval %lu +- %lu ms%s\n",
+            n->addr.u8[0], n->addr.u8[1], n->last_seqno, n->missed,
+            n->mean_interval * 1000UL / CLOCK_SECOND,
+            n->dev_interval * 1000UL / CLOCK_SECOND,
+            (n->flags & NEIGHBOR_PROVISIONAL) ? "  provisional" : "");
+  }
+}
+/*---------------------------------------------------------------------------*/
+#if NODE_ROLE == NODE_ROLE_RECEIVER
+static void
+print_sensors(void)
+{
+  const struct ac_sensor *s;
+  unsigned long i, j;
+  uint8_t z;
+
+  for(z = 0; z < AC_CONTROLLER_ZONES; z++) {
+    fprintf(report, "zone %u             AC %s\n", z,
+            (ac_controller_state() & (1 << z)) ? "ON" : "OFF");
+  }
+  /* The controller has no iterator, so look up every sender of a PING,
+     once. */
+  for(i = 0; i < trace_len; i++) {
+    if((trace[i].flags & (FRAME_TRACE_TX | FRAME_TRACE_UNICAST)) !=
+       FRAME_TRACE_UNICAST || trace[i].len < 1 ||
+       trace[i].data[0] != UNICAST_TYPE_PING) {
+      continue;
+    }
+    for(j = 0; j < i; j++) {
+      if(trace[j].flags == trace[i].flags && trace[j].len >= 1 &&
+         trace[j].data[0] == UNICAST_TYPE_PING &&
+         linkaddr_cmp(&trace[j].addr, &trace[i].addr)) {
+        break;
+      }
+    }
+    s = ac_controller_sensor(&trace[i].addr);
+    if(j < i || s == NULL) {
+      continue;
+    }
+    fprintf(report, "  sensor %d.%d  zone %u  temp %u  trend %d/16  period %u s\n",
+            s->addr.u8[0], s->addr.u8[1], s->zone, s->temp, s->trend,
+            s->period);
+  }
+}
+#endif
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-r] [-v] trace\n", prog);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  const uint8_t *header;
+  const struct frame *f;
+  uint32_t *lat;
+  unsigned long i, rx, tx;
+  double start, elapsed, total_ns, ns, wait;
+  int opt, verbose = 0, realtime = 0;
+  struct timespec ts;
+
+  while((opt = getopt(argc, argv, "rv")) != -1) {
+    switch(opt) {
+    case 'r': realtime = 1; break;
+    case 'v': verbose = 1; break;
+    default: usage(argv[0]);
+    }
+  }
+  if(optind != argc - 1) {
+    usage(argv[0]);
+  }
+  header = load(argv[optind]);
+  lat = malloc((trace_len + 1) * sizeof(uint32_t));
+  if(lat == NULL) {
+    fprintf(stderr, "out of memory\n");
+    exit(1);
+  }
+
+  /* The firmware prints for every frame; keep that out of the report
+     unless asked for. */
+  report = fdopen(dup(1), "w");
+  if(!verbose) {
+    freopen("/dev/null", "w", stdout);
+  }
+
+  if(header[3] != NODE_ROLE) {
+    fprintf(report, "warning: the trace was recorded by a %s\n",
+            header[3] == NODE_ROLE_RECEIVER ? "receiver" : "sender");
+  }
+  memcpy(&linkaddr_node_addr, header + 4, sizeof(linkaddr_t));
+
+  /* Start from an empty neighbor snapshot, as the trace does. */
+  cfs_remove("nbr0");
+  cfs_remove("nbr1");
+
+  native_rime_output = compare_output;
+  native_autostart();
+
+  for(i = tx = 0; i < trace_len; i++) {
+    tx += (trace[i].flags & FRAME_TRACE_TX) != 0;
+  }
+  rx = 0;
+  total_ns = 0;
+  start = now_ns();
+  for(i = 0; i < trace_len; i++) {
+    f = &trace[i];
+    if(f->flags & FRAME_TRACE_TX) {
+      continue;
+    }
+    if(realtime) {
+      wait = (double)f->time / CLOCK_SECOND - (now_ns() - start) / 1e9;
+      if(wait > 0) {
+        ts.tv_sec = (time_t)wait;
+        ts.tv_nsec = (long)((wait - ts.tv_sec) * 1e9);
+        nanosleep(&ts, NULL);
+      }
+    }
+    native_run(f->time);
+    ns = now_ns();
+    if(f->flags & FRAME_TRACE_UNICAST) {
+      native_rime_input(NODE_UNICAST_CHANNEL, &f->addr, &linkaddr_node_addr,
+                        f->data, f->len);
+    } else {
+      native_rime_input(NODE_BROADCAST_CHANNEL, &f->addr, NULL,
+                        f->data, f->len);
+    }
+    ns = now_ns() - ns;
+    lat[rx++] = (uint32_t)ns;
+    total_ns += ns;
+  }
+  /* Let the transmit queue drain. */
+  if(trace_len > 0) {
+    native_run(trace[trace_len - 1].time + CLOCK_SECOND);
+  }
+  elapsed = (now_ns() - start) / 1e9;
+
+  qsort(lat, rx, sizeof(uint32_t), cmp_u32);
+
+#define PCT(p) (rx ? lat[(unsigned long)((rx - 1) * (p))] : 0)
+  fprintf(report, "frames in trace    %lu received, %lu sent\n", rx, tx);
+  fprintf(report, "virtual time       %.1f s\n", trace_len > 0 ?
+          (double)trace[trace_len - 1].time / CLOCK_SECOND : 0);
+  fprintf(report, "wall time          %.3f s\n", elapsed);
+  fprintf(report, "latency ns         p50 %u  p90 %u  p99 %u  max %u  total %.0f\n",
+          PCT(0.5), PCT(0.9), PCT(0.99), rx ? lat[rx - 1] : 0, total_ns);
+  fprintf(report, "frames sent        %lu, %lu as in the trace, %lu past its end",
+          tx_sent, tx_matched, tx_extra);
+  if(tx_diverged != ~0UL) {
+    fprintf(report, ", first difference at frame %lu", tx_diverged);
+  }
+  fprintf(report, "\n");
+#undef PCT
+  print_neighbors();
+#if NODE_ROLE == NODE_ROLE_RECEIVER
+  print_sensors();
+#endif
+
+  fclose(report);
+  return 0;
+}
@@ -0,0 +1,174 @@
+/*
+ * Stubbed Rime layer: a single packetbuf and a table of open broadcast
+ * and unicast connections, indexed by channel.
+ */
+#include "contiki.h"
+#include "net/rime/rime.h"
+
+#include <string.h>
+
+#define MAX_CONNS 8
+
+struct conn {
+  uint16_t channel;
+  struct broadcast_conn *bc;
+  struct unicast_conn *uc;
+};
+static struct conn conns[MAX_CONNS];
+
+static uint8_t packetbuf[PACKETBUF_SIZE];
+static uint16_t packetbuf_len;
+
+void (* native_rime_output)(uint16_t channel, const linkaddr_t *to,
+                            const void *data, int len);
+
+/*---------------------------------------------------------------------------*/
+void
+packetbuf_clear(void)
+{
+  packetbuf_len = 0;
+}
+/*---------------------------------------------------------------------------*/
+void *
+packetbuf_dataptr(void)
+{
+  return packetbuf;
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+packetbuf_datalen(void)
+{
+  return packetbuf_len;
+}
+/*---------------------------------------------------------------------------*/
+void
+packetbuf_set_datalen(uint16_t len)
+{
+  packetbuf_len = len;
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_copyfrom(const void *from, uint16_t len)
+{
+  if(len > PACKETBUF_SIZE) {
+    len = PACKETBUF_SIZE;
+  }
+  memmove(packetbuf, from, len);
+  packetbuf_len = len;
+  return len;
+}
+/*---------------------------------------------------------------------------*/
+int
+packetbuf_copyto(void *to)
+{
+  memcpy(to, packetbuf, packetbuf_len);
+  return packetbuf_len;
+}
+/*---------------------------------------------------------------------------*/
+static struct conn *
+conn_alloc(uint16_t channel)
+{
+  int i;
+
+  for(i = 0; i < MAX_CONNS; i++) {
+    if(conns[i].bc == NULL && conns[i].uc == NULL) {
+      conns[i].channel = channel;
+      return &conns[i];
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+static void
+conn_free(void *c)
+{
+  int i;
+
+  for(i = 0; i < MAX_CONNS; i++) {
+    if((void *)conns[i].bc == c || (void *)conns[i].uc == c) {
+      conns[i].bc = NULL;
+      conns[i].uc = NULL;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+broadcast_open(struct broadcast_conn *c, uint16_t channel,
+               const struct broadcast_callbacks *u)
+{
+  struct conn *conn = conn_alloc(channel);
+
+  c->channel = channel;
+  c->u = u;
+  if(conn != NULL) {
+    conn->bc = c;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+broadcast_close(struct broadcast_conn *c)
+{
+  conn_free(c);
+}
+/*---------------------------------------------------------------------------*/
+int
+broadcast_send(struct broadcast_conn *c)
+{
+  if(native_rime_output != NULL) {
+    native_rime_output(c->channel, NULL, packetbuf, packetbuf_len);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+void
+unicast_open(struct unicast_conn *c, uint16_t channel,
+             const struct unicast_callbacks *u)
+{
+  struct conn *conn = conn_alloc(channel);
+
+  c->c.channel = channel;
+  c->u = u;
+  if(conn != NULL) {
+    conn->uc = c;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+unicast_close(struct unicast_conn *c)
+{
+  conn_free(c);
+}
+/*---------------------------------------------------------------------------*/
+int
+unicast_send(struct unicast_conn *c, const linkaddr_t *receiver)
+{
+  if(native_rime_output != NULL) {
+    native_rime_output(c->c.channel, receiver, packetbuf, packetbuf_len);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+int
+native_rime_input(uint16_t channel, const linkaddr_t *from,
+                  const linkaddr_t *to, const void *data, int len)
+{
+  int i;
+
+  for(i = 0; i < MAX_CONNS; i++) {
+    if(conns[i].channel != channel) {
+      continue;
+    }
+    if(to == NULL && conns[i].bc != NULL && conns[i].bc->u->recv != NULL) {
+      packetbuf_copyfrom(data, len);
+      conns[i].bc->u->recv(conns[i].bc, from);
+      return 1;
+    }
+    if(to != NULL && conns[i].uc != NULL && conns[i].uc->u->recv != NULL) {
+      packetbuf_copyfrom(data, len);
+      conns[i].uc->u->recv(conns[i].uc, from);
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,266 @@
+/*
+ * Throughput stress harness for receiver.c.
+ *
+ * The receiver is compiled for the host against the stubbed Contiki and
+ * Rime layers in this directory, and flooded with PING, heartbeat and AC
+ * frames from a configurable number of synthetic sender addresses.
+ * Frames arrive as a Poisson process at the offered rate, in virtual
+ * time. Every receive callback is timed on the host clock, and the
+ * measured time (scaled by -k to approximate the MCU) is used to decide
+ * whether the single receive buffer would still be busy when the next
+ * frame arrives, in which case that frame is dropped.
+ *
+ *   ./stress-receiver [-n frames] [-s senders] [-r rate] [-m ping:hb:ac]
+ *                     [-k slowdown] [-S] [-v]
+ *
+ * With -S the offered rate is doubled from -r until more than 1% of the
+ * frames are dropped, and one line is printed per rate.
+ */
+#include "../receiver.c"
+
+#include "cfs/cfs.h"
+#include "neighbor-table.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+static FILE *report;
+
+static unsigned long frames = 100000;
+static unsigned senders = 2000;
+static double rate = 100;
+static unsigned mix_ping = 80, mix_hb = 15, mix_ac = 5;
+static double slowdown = 1;
+
+static unsigned long tx_bc, tx_uc;
+
+/*---------------------------------------------------------------------------*/
+static void
+count_output(uint16_t channel, const linkaddr_t *to, const void *data, int len)
+{
+  if(to == NULL) {
+    tx_bc++;
+  } else {
+    tx_uc++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static double
+now_ns(void)
+{
+  struct timespec ts;
+
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+/*---------------------------------------------------------------------------*/
+static int
+cmp_u32(const void *a, const void *b)
+{
+  uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+
+  return x < y ? -1 : x > y;
+}
+/*---------------------------------------------------------------------------*/
+static double
+run(double offered, int summary_only)
+{
+  uint32_t *lat;
+  uint8_t *temps, *seqnos;
+  unsigned long i, delivered, dropped, table_drops;
+  double t, busy_until, start, elapsed, total_ns, ns;
+  struct unicast_message ping;
+  struct broadcast_message bc;
+  linkaddr_t from;
+  unsigned s, kind;
+
+  lat = malloc(frames * sizeof(uint32_t));
+  temps = malloc(senders);
+  seqnos = calloc(senders, 1);
+  if(lat == NULL || temps == NULL || seqnos == NULL) {
+    fprintf(report, "out of memory\n");
+    exit(1);
+  }
+  srand(1);
+  for(s = 0; s < senders; s++) {
+    temps[s] = 40 + rand() % 60;
+  }
+
+  /* Start from an empty neighbor snapshot, so runs are repeatable. */
+  cfs_remove("nbr0");
+  cfs_remove("nbr1");
+
+  native_rime_output = count_output;
+  native_autostart();
+
+  t = 0;
+  busy_until = 0;
+  delivered = dropped = table_drops = 0;
+  total_ns = 0;
+  start = now_ns();
+
+  for(i = 0; i < frames; i++) {
+    t += -log((rand() + 1.0) / (RAND_MAX + 2.0)) / offered;
+    native_run((clock_time_t)(t * CLOCK_SECOND));
+
+    s = rand() % senders;
+    from.u8[0] = (s + 1) & 0xff;
+    from.u8[1] = (s + 1) >> 8;
+    kind = rand() % (mix_ping + mix_hb + mix_ac);
+
+    if(t < busy_until) {
+      dropped++;
+      continue;
+    }
+
+    if(kind < mix_ping) {
+      temps[s] += rand() % 7 - 3;
+      temps[s] = temps[s] < 20 ? 20 : (temps[s] > 110 ? 110 : temps[s]);
+      ping.type = UNICAST_TYPE_PING;
+      ping.temp = temps[s];
+      ping.period = 0;
+      ping.seqno = (uint8_t)i;
+      ns = now_ns();
+      native_rime_input(146, &from, &linkaddr_node_addr, &ping, sizeof(ping));
+      ns = now_ns() - ns;
+      if(ac_controller_sensor(&from) == NULL) {
+        table_drops++;
+      }
+    } else {
+      bc.seqno = seqnos[s]++;
+      bc.id = 0;
+      bc.AC = 2;
+      bc.zone = 0;
+      if(kind >= mix_ping + mix_hb) {
+        bc.id = 1;
+        bc.AC = rand() & 1;
+        bc.zone = rand() % AC_CONTROLLER_ZONES;
+      }
+      ns = now_ns();
+      native_rime_input(129, &from, NULL, &bc, sizeof(bc));
+      ns = now_ns() - ns;
+      if(bc.AC == 2 && neighbor_table_find(&from) == NULL) {
+        table_drops++;
+      }
+    }
+
+    lat[delivered++] = (uint32_t)ns;
+    total_ns += ns;
+    busy_until = t + ns * slowdown / 1e9;
+  }
+  elapsed = (now_ns() - start) / 1e9;
+
+  qsort(lat, delivered, sizeof(uint32_t), cmp_u32);
+
+#define PCT(p) (delivered ? lat[(unsigned long)((delivered - 1) * (p))] : 0)
+  if(summary_only) {
+    fprintf(report, "%10.0f %10.0f %8.2f%% %8.2f%% %8u %8u %8u\n",
+            offered, delivered / (total_ns / 1e9),
+            100.0 * dropped / frames, 100.0 * table_drops / frames,
+            PCT(0.5), PCT(0.99), delivered ? lat[delivered - 1] : 0);
+  } else {
+    fprintf(report, "frames offered     %lu at %.0f/s from %u senders\n",
+            frames, offered, senders);
+    fprintf(report, "frames delivered   %lu\n", delivered);
+    fprintf(report, "frames dropped     %lu (receiver busy)\n", dropped);
+    fprintf(report, "table drops        %lu (sensor or neighbor table full)\n",
+            table_drops);
+    fprintf(report, "frames sent        %lu unicast, %lu broadcast\n",
+            tx_uc, tx_bc);
+    fprintf(report, "virtual time       %.1f s\n", t);
+    fprintf(report, "wall time          %.3f s\n", elapsed);
+    fprintf(report, "sustained          %.0f packets/s in callbacks\n",
+            delivered / (total_ns / 1e9));
+    fprintf(report, "latency ns         p50 %u  p90 %u  p99 %u  p99.9 %u  max %u\n",
+            PCT(0.5), PCT(0.9), PCT(0.99), PCT(0.999),
+            delivered ? lat[delivered - 1] : 0);
+  }
+#undef PCT
+
+  free(lat);
+  free(temps);
+  free(seqnos);
+  return (double)dropped / frames;
+}
+/*---------------------------------------------------------------------------*/
+static void
+sweep(void)
+{
+  double offered;
+  pid_t pid;
+  int status;
+
+  fprintf(report, "%10s %10s %9s %9s %8s %8s %8s\n", "offered/s",
+          "sustained", "dropped", "table", "p50 ns", "p99 ns", "max ns");
+  fflush(report);
+  for(offered = rate; offered < 1e7; offered *= 2) {
+    /* The receiver keeps its state in statics, so every rate gets a
+       fresh process. */
+    pid = fork();
+    if(pid == 0) {
+      status = run(offered, 1) > 0.01;
+      fflush(report);
+      exit(status);
+    }
+    if(pid < 0 || waitpid(pid, &status, 0) < 0 ||
+       !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+      break;
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+static void
+usage(const char *prog)
+{
+  fprintf(stderr, "usage: %s [-n frames] [-s senders] [-r rate] "
+          "[-m ping:hb:ac] [-k slowdown] [-S] [-v]\n", prog);
+  exit(1);
+}
+/*---------------------------------------------------------------------------*/
+int
+main(int argc, char **argv)
+{
+  int opt, verbose = 0, do_sweep = 0;
+
+  while((opt = getopt(argc, argv, "n:s:r:m:k:Sv")) != -1) {
+    switch(opt) {
+    case 'n': frames = strtoul(optarg, NULL, 10); break;
+    case 's': senders = strtoul(optarg, NULL, 10); break;
+    case 'r': rate = atof(optarg); break;
+    case 'm':
+      if(sscanf(optarg, "%u:%u:%u", &mix_ping, &mix_hb, &mix_ac) != 3) {
+        usage(argv[0]);
+      }
+      break;
+    case 'k': slowdown = atof(optarg); break;
+    case 'S': do_sweep = 1; break;
+    case 'v': verbose = 1; break;
+    default: usage(argv[0]);
+    }
+  }
+  if(frames == 0 || senders == 0 || senders > 65535 || rate <= 0 ||
+     mix_ping + mix_hb + mix_ac == 0) {
+    usage(argv[0]);
+  }
+
+  /* The firmware prints for every frame; keep that out of the report
+     unless asked for. */
+  report = fdopen(dup(1), "w");
+  if(!verbose) {
+    freopen("/dev/null", "w", stdout);
+  }
+
+  linkaddr_node_addr.u8[0] = 0;
+  linkaddr_node_addr.u8[1] = 0xff;
+
+  if(do_sweep) {
+    sweep();
+  } else {
+    run(rate, 0);
+  }
+  fclose(report);
+  return 0;
+}
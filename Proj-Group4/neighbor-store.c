@@ -0,0 +1,188 @@
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "lib/crc16.h"
+#include "lib/list.h"
+#include "neighbor-table.h"
+#include "neighbor-store.h"
+#include "task-sched.h"
+
+#include <stddef.h>
+#include <stdio.h>
+
+/* Snapshots alternate between two files, so that a reset in the middle
+   of a write still leaves the previous snapshot intact. Each file is
+   removed before it is rewritten, which keeps the file system from
+   logging the overwrite. */
+static const char *files[2] = { "nbr0", "nbr1" };
+
+#define STORE_MAGIC 0x4e42
+
+struct store_header {
+  uint16_t magic;
+  uint16_t seq;
+  /* The last epoch reserved. */
+  uint16_t epoch;
+  uint8_t count;
+  uint8_t pad;
+  uint16_t crc;
+};
+
+struct store_entry {
+  linkaddr_t addr;
+  uint8_t last_seqno;
+  uint8_t pad;
+  uint16_t avg_seqno_gap;
+};
+
+/* Used both for restoring and for writing snapshots. */
+static struct store_entry entries[MAX_NEIGHBORS];
+
+static struct sched_task write_task;
+
+/* The last epoch used and the last one reserved in flash. */
+static uint16_t epoch, epoch_end;
+static uint16_t seq;
+static uint8_t next_file;
+static uint8_t written;
+static clock_time_t last_write;
+
+/*---------------------------------------------------------------------------*/
+static uint16_t
+entries_crc(const struct store_header *h, const struct store_entry *e)
+{
+  uint16_t crc;
+
+  crc = crc16_data((const unsigned char *)h,
+                   offsetof(struct store_header, crc), 0);
+  return crc16_data((const unsigned char *)e,
+                    h->count * sizeof(struct store_entry), crc);
+}
+/*---------------------------------------------------------------------------*/
+/* Read one snapshot file into h and e. Returns 0 if it is not valid. */
+static int
+read_file(const char *name, struct store_header *h, struct store_entry *e)
+{
+  int fd, ok;
+
+  fd = cfs_open(name, CFS_READ);
+  if(fd < 0) {
+    return 0;
+  }
+  ok = cfs_read(fd, h, sizeof(*h)) == sizeof(*h) &&
+    h->magic == STORE_MAGIC && h->count <= MAX_NEIGHBORS &&
+    cfs_read(fd, e, h->count * sizeof(*e)) == h->count * sizeof(*e) &&
+    h->crc == entries_crc(h, e);
+  cfs_close(fd);
+  return ok;
+}
+/*---------------------------------------------------------------------------*/
+static void
+write_snapshot(void *ptr)
+{
+  struct store_header h;
+  struct neighbor *n;
+  int fd, len;
+
+  h.magic = STORE_MAGIC;
+  h.seq = ++seq;
+  h.epoch = epoch_end;
+  h.count = 0;
+  h.pad = 0;
+  for(n = neighbor_table_head(); n != NULL && h.count < MAX_NEIGHBORS;
+      n = list_item_next(n)) {
+    linkaddr_copy(&entries[h.count].addr, &n->addr);
+    entries[h.count].last_seqno = n->last_seqno;
+    entries[h.count].pad = 0;
+    entries[h.count].avg_seqno_gap = n->avg_seqno_gap;
+    h.count++;
+  }
+  h.crc = entries_crc(&h, entries);
+
+  cfs_remove(files[next_file]);
+  fd = cfs_open(files[next_file], CFS_WRITE);
+  if(fd < 0) {
+    return;
+  }
+  len = h.count * sizeof(struct store_entry);
+  if(cfs_write(fd, &h, sizeof(h)) != sizeof(h) ||
+     cfs_write(fd, entries, len) != len) {
+    printf("Neighbor snapshot write failed\n");
+  }
+  cfs_close(fd);
+
+  next_file ^= 1;
+  written = 1;
+  last_write = clock_time();
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_store_init(void)
+{
+  struct store_header h;
+  uint16_t best;
+  uint8_t i, f, found;
+
+  found = 0;
+  best = 0;
+  for(f = 0; f < 2; f++) {
+    if(read_file(files[f], &h, entries) &&
+       (!found || (int16_t)(h.seq - best) > 0)) {
+      best = h.seq;
+      next_file = f ^ 1;
+      found = 1;
+    }
+  }
+  if(!found) {
+    return;
+  }
+
+  /* The entries buffer was overwritten by the second file, so read the
+     newest one again. */
+  read_file(files[next_file ^ 1], &h, entries);
+  seq = h.seq;
+  /* Epochs up to the end of the reserved block may have been used
+     before the reset. */
+  epoch = h.epoch;
+  epoch_end = h.epoch;
+  for(i = 0; i < h.count; i++) {
+    neighbor_table_restore(&entries[i].addr, entries[i].last_seqno,
+                           entries[i].avg_seqno_gap);
+  }
+  printf("Restored %d neighbors, epoch %u\n", h.count, epoch);
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_store_changed(void)
+{
+  clock_time_t since, delay;
+
+  if(sched_pending(&write_task)) {
+    return;
+  }
+  delay = NEIGHBOR_STORE_HOLDOFF;
+  if(written) {
+    since = clock_time() - last_write;
+    if(since < NEIGHBOR_STORE_MIN_INTERVAL &&
+       NEIGHBOR_STORE_MIN_INTERVAL - since > delay) {
+      delay = NEIGHBOR_STORE_MIN_INTERVAL - since;
+    }
+  }
+  sched_set(&write_task, delay, delay + NEIGHBOR_STORE_HOLDOFF,
+            write_snapshot, NULL);
+}
+/*---------------------------------------------------------------------------*/
+uint16_t
+neighbor_store_next_epoch(void)
+{
+  epoch++;
+  /* Reserve the next block before its first epoch is used. This write
+     does not wait for the minimum interval, and it carries any table
+     change that was waiting. */
+  if((int16_t)(epoch - epoch_end) > 0) {
+    epoch_end = epoch + NEIGHBOR_STORE_EPOCH_BLOCK - 1;
+    sched_stop(&write_task);
+    write_snapshot(NULL);
+  }
+  return epoch;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,46 @@
+#ifndef NEIGHBOR_STORE_H_
+#define NEIGHBOR_STORE_H_
+
+#include "contiki.h"
+
+/* Snapshots of the neighbor table are written at most this often, to
+   spare the flash. */
+#ifdef NEIGHBOR_STORE_CONF_MIN_INTERVAL
+#define NEIGHBOR_STORE_MIN_INTERVAL NEIGHBOR_STORE_CONF_MIN_INTERVAL
+#else
+#define NEIGHBOR_STORE_MIN_INTERVAL (5 * 60 * CLOCK_SECOND)
+#endif
+
+/* A change is held back this long before it is written, so that a
+   burst of changes costs a single write. */
+#ifdef NEIGHBOR_STORE_CONF_HOLDOFF
+#define NEIGHBOR_STORE_HOLDOFF NEIGHBOR_STORE_CONF_HOLDOFF
+#else
+#define NEIGHBOR_STORE_HOLDOFF (10 * CLOCK_SECOND)
+#endif
+
+/* Command epochs are reserved in blocks of this many. A snapshot holds
+   the end of the block in use, and a node that resets continues after
+   it. No epoch is reused, at the cost of skipping the rest of the
+   block, and only the first command of a block waits for a write.
+   Commands carry only the low 8 bits of the epoch, which wrap, see
+   struct broadcast_message. */
+#ifdef NEIGHBOR_STORE_CONF_EPOCH_BLOCK
+#define NEIGHBOR_STORE_EPOCH_BLOCK NEIGHBOR_STORE_CONF_EPOCH_BLOCK
+#else
+#define NEIGHBOR_STORE_EPOCH_BLOCK 16
+#endif
+
+/* Restore the neighbor table and the command epoch from the latest
+   valid snapshot in flash. Call after neighbor_table_init(). */
+void neighbor_store_init(void);
+
+/* Mark the table as changed. A snapshot will be written once the
+   holdoff and the minimum interval have passed. */
+void neighbor_store_changed(void);
+
+/* Return the epoch for the next command this node sends. It is
+   persisted with the neighbor table before it is returned. */
+uint16_t neighbor_store_next_epoch(void);
+
+#endif /* NEIGHBOR_STORE_H_ */
@@ -0,0 +1,384 @@
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "lib/random.h"
+#include "dev/leds.h"
+#include "neighbor-table.h"
+#include "task-sched.h"
+
+#include <stdio.h>
+
+/* This MEMB() definition defines a memory pool from which we allocate
+   neighbor entries. */
+MEMB(neighbors_memb, struct neighbor, MAX_NEIGHBORS);
+
+/* The neighbors_list is a Contiki list that holds the neighbors we
+   have seen thus far. */
+LIST(neighbors_list);
+
+/* A single task expires neighbors, instead of one timer per entry. */
+static struct sched_task sweep_task;
+
+static const struct neighbor_table_callbacks *cb;
+
+static void sweep(void *ptr);
+
+/*---------------------------------------------------------------------------*/
+/* Stretch a timeout by the average sequence number gap of a neighbor,
+   so that a lossy link is given the time to get a heartbeat through. */
+static uint32_t
+stretch(struct neighbor *n, uint32_t t)
+{
+  uint16_t gap;
+
+  gap = n->avg_seqno_gap;
+  if(gap < SEQNO_EWMA_UNITY) {
+    gap = SEQNO_EWMA_UNITY;
+  } else if(gap > NEIGHBOR_MAX_GAP * SEQNO_EWMA_UNITY) {
+    gap = NEIGHBOR_MAX_GAP * SEQNO_EWMA_UNITY;
+  }
+  return t * gap / SEQNO_EWMA_UNITY;
+}
+/*---------------------------------------------------------------------------*/
+/* How long a neighbor may stay silent before we declare it failed. */
+static clock_time_t
+timeout(struct neighbor *n)
+{
+  uint32_t t, limit;
+
+  if(n->flags & NEIGHBOR_PROVISIONAL) {
+    return stretch(n, NEIGHBOR_PROVISIONAL_TIMEOUT);
+  }
+  limit = stretch(n, NEIGHBOR_TIMEOUT);
+  if(n->samples < NEIGHBOR_MIN_SAMPLES) {
+    return limit;
+  }
+  /* The mean interval is per heartbeat sent, and one more may be lost */
+  t = stretch(n, n->mean_interval) + n->mean_interval +
+    (uint32_t)NEIGHBOR_DEV_K * n->dev_interval;
+  if(t < NEIGHBOR_MIN_TIMEOUT) {
+    return NEIGHBOR_MIN_TIMEOUT;
+  }
+  return t > limit ? limit : t;
+}
+/*---------------------------------------------------------------------------*/
+/* The time left until a neighbor fails, counting each missed ping
+   beyond the free ones as a missed heartbeat interval. */
+static clock_time_t
+time_left(struct neighbor *n)
+{
+  uint32_t evidence;
+  clock_time_t limit;
+  uint8_t missed;
+
+  limit = timeout(n);
+  missed = n->missed > NEIGHBOR_FREE_MISSES ?
+    n->missed - NEIGHBOR_FREE_MISSES : 0;
+  evidence = (clock_time_t)(clock_time() - n->last_seen) +
+    (uint32_t)missed * (n->samples > 0 ? n->mean_interval : limit);
+  return evidence >= limit ? 0 : limit - evidence;
+}
+/*---------------------------------------------------------------------------*/
+/* Schedule the sweep for when the first neighbor times out. */
+static void
+schedule_sweep(void)
+{
+  struct neighbor *n;
+  clock_time_t left, next;
+
+  n = list_head(neighbors_list);
+  if(n == NULL) {
+    sched_stop(&sweep_task);
+    return;
+  }
+  next = time_left(n);
+  for(n = list_item_next(n); n != NULL; n = list_item_next(n)) {
+    left = time_left(n);
+    if(left < next) {
+      next = left;
+    }
+  }
+  sched_set(&sweep_task, next, next + (next > 0 ? NEIGHBOR_SLACK : 0),
+            sweep, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+remove_neighbor(struct neighbor *e)
+{
+  printf("Removed node %d from the list\n", e->addr.u8[0]);
+  leds_on(LEDS_RED);
+  list_remove(neighbors_list, e);
+  if(cb != NULL && cb->removed != NULL) {
+    cb->removed(e);
+  }
+  memb_free(&neighbors_memb, e);
+}
+/*---------------------------------------------------------------------------*/
+/*
+ * This function is called by the sweep task. It removes the neighbors
+ * we no longer trust to be alive from the table.
+ */
+static void
+sweep(void *ptr)
+{
+  struct neighbor *e, *next;
+
+  for(e = list_head(neighbors_list); e != NULL; e = next) {
+    next = list_item_next(e);
+    if(time_left(e) == 0) {
+      remove_neighbor(e);
+    }
+  }
+  schedule_sweep();
+}
+/*---------------------------------------------------------------------------*/
+/* Fold a new heartbeat inter-arrival time into the statistics. Only
+   heartbeats advance the sequence numbers, so a gap in them means we
+   missed heartbeats in between, and the interval is split over them. */
+static void
+update_interval(struct neighbor *n, uint8_t seqno_gap)
+{
+  clock_time_t x;
+  int32_t err;
+
+  x = clock_time() - n->last_beat;
+  if(seqno_gap > 1) {
+    x /= seqno_gap;
+  }
+  if(x > NEIGHBOR_TIMEOUT) {
+    x = NEIGHBOR_TIMEOUT;
+  }
+  if(n->samples == 0) {
+    n->mean_interval = x;
+    n->dev_interval = x / 2;
+  } else {
+    err = (int32_t)x - n->mean_interval;
+    n->mean_interval += err / 8;
+    if(err < 0) {
+      err = -err;
+    }
+    n->dev_interval += (err - (int32_t)n->dev_interval) / 4;
+  }
+  if(n->samples < 255) {
+    n->samples++;
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_table_init(const struct neighbor_table_callbacks *callbacks)
+{
+  cb = callbacks;
+  memb_init(&neighbors_memb);
+  list_init(neighbors_list);
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_find(const linkaddr_t *addr)
+{
+  struct neighbor *n;
+
+  for(n = list_head(neighbors_list); n != NULL; n = list_item_next(n)) {
+    if(linkaddr_cmp(&n->addr, addr)) {
+      return n;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+/* Look up a neighbor, or add it if it is new. Returns NULL if the
+   table is full. */
+static struct neighbor *
+find_or_add(const linkaddr_t *addr, uint8_t seqno)
+{
+  struct neighbor *n;
+
+  n = neighbor_table_find(addr);
+
+  /* If n is NULL, this neighbor was not found in our list, and we
+     allocate a new struct neighbor from the neighbors_memb memory
+     pool. */
+  if(n == NULL) {
+    n = memb_alloc(&neighbors_memb);
+
+    /* If we could not allocate a new neighbor entry, we give up. We
+       could have reused an old neighbor entry, but we do not do this
+       for now. */
+    if(n == NULL) {
+      return NULL;
+    }
+
+    /* Initialize the fields. */
+    linkaddr_copy(&n->addr, addr);
+    n->flags = 0;
+    n->missed = 0;
+    n->samples = 0;
+    n->last_seqno = seqno;
+    n->avg_seqno_gap = SEQNO_EWMA_UNITY;
+    n->last_seen = clock_time();
+    list_add(neighbors_list, n);
+    if(cb != NULL && cb->added != NULL) {
+      cb->added(n);
+    }
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+/* We heard from a neighbor, so it is alive. */
+static void
+refresh(struct neighbor *n)
+{
+  n->last_seen = clock_time();
+  n->missed = 0;
+  n->flags &= ~NEIGHBOR_PROVISIONAL;
+  schedule_sweep();
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_add(const linkaddr_t *addr, uint8_t seqno)
+{
+  struct neighbor *n;
+  uint8_t seqno_gap;
+
+  /* A new neighbor starts with a gap of one. */
+  n = find_or_add(addr, seqno - 1);
+  if(n == NULL) {
+    return NULL;
+  }
+
+  /* Update the link estimate from the sequence number gap. */
+  seqno_gap = seqno - n->last_seqno;
+  n->avg_seqno_gap = (((uint32_t)seqno_gap * SEQNO_EWMA_UNITY) *
+                      SEQNO_EWMA_ALPHA) / SEQNO_EWMA_UNITY +
+    ((uint32_t)n->avg_seqno_gap * (SEQNO_EWMA_UNITY - SEQNO_EWMA_ALPHA)) /
+    SEQNO_EWMA_UNITY;
+
+  /* An interval needs two heartbeats that we heard ourselves, so none
+     is measured on the first one, including the first one after the
+     neighbor was restored from flash. */
+  if(seqno_gap > 0) {
+    if(n->flags & NEIGHBOR_BEAT) {
+      update_interval(n, seqno_gap);
+    }
+    n->last_beat = clock_time();
+    n->flags |= NEIGHBOR_BEAT;
+  }
+
+  /* Remember last seqno we heard. */
+  n->last_seqno = seqno;
+  refresh(n);
+
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_heard(const linkaddr_t *addr, uint8_t seqno)
+{
+  struct neighbor *n;
+
+  n = find_or_add(addr, seqno);
+  if(n == NULL) {
+    return NULL;
+  }
+
+  /* Until we hear a heartbeat, its number is where the gap to the next
+     one is counted from. */
+  if(!(n->flags & NEIGHBOR_BEAT)) {
+    n->last_seqno = seqno;
+  }
+  refresh(n);
+
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_restore(const linkaddr_t *addr, uint8_t seqno,
+                       uint16_t avg_seqno_gap)
+{
+  struct neighbor *n;
+
+  if(neighbor_table_find(addr) != NULL) {
+    return NULL;
+  }
+  n = memb_alloc(&neighbors_memb);
+  if(n == NULL) {
+    return NULL;
+  }
+  linkaddr_copy(&n->addr, addr);
+  n->last_seqno = seqno;
+  n->avg_seqno_gap = avg_seqno_gap;
+  n->flags = NEIGHBOR_PROVISIONAL;
+  n->missed = 0;
+  n->samples = 0;
+  n->last_seen = clock_time();
+  list_add(neighbors_list, n);
+  schedule_sweep();
+
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+void
+neighbor_table_confirm(const linkaddr_t *addr)
+{
+  struct neighbor *n;
+
+  n = neighbor_table_find(addr);
+  if(n != NULL && ((n->flags & NEIGHBOR_PROVISIONAL) || n->missed > 0)) {
+    if(n->flags & NEIGHBOR_PROVISIONAL) {
+      n->flags &= ~NEIGHBOR_PROVISIONAL;
+      n->last_seen = clock_time();
+    }
+    n->missed = 0;
+    schedule_sweep();
+  }
+}
+/*---------------------------------------------------------------------------*/
+int
+neighbor_table_missed(const linkaddr_t *addr)
+{
+  struct neighbor *n;
+
+  n = neighbor_table_find(addr);
+  if(n == NULL) {
+    return 0;
+  }
+  if(n->missed < 255) {
+    n->missed++;
+  }
+  if(time_left(n) == 0) {
+    remove_neighbor(n);
+    schedule_sweep();
+    return 1;
+  }
+  schedule_sweep();
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_random(void)
+{
+  struct neighbor *n;
+  int i, randneighbor;
+
+  if(list_length(neighbors_list) == 0) {
+    return NULL;
+  }
+  randneighbor = random_rand() % list_length(neighbors_list);
+  n = list_head(neighbors_list);
+  for(i = 0; i < randneighbor; i++) {
+    n = list_item_next(n);
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+int
+neighbor_table_length(void)
+{
+  return list_length(neighbors_list);
+}
+/*---------------------------------------------------------------------------*/
+struct neighbor *
+neighbor_table_head(void)
+{
+  return list_head(neighbors_list);
+}
+/*---------------------------------------------------------------------------*/
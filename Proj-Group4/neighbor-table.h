@@ -0,0 +1,142 @@
+#ifndef NEIGHBOR_TABLE_H_
+#define NEIGHBOR_TABLE_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+/* This #define defines the maximum amount of neighbors we can remember. */
+#ifdef NEIGHBOR_TABLE_CONF_MAX_NEIGHBORS
+#define MAX_NEIGHBORS NEIGHBOR_TABLE_CONF_MAX_NEIGHBORS
+#else
+#define MAX_NEIGHBORS 16
+#endif
+
+/* Until NEIGHBOR_MIN_SAMPLES heartbeat intervals of a neighbor have
+   been measured it times out after NEIGHBOR_TIMEOUT of silence. After
+   that the timeout adapts to the neighbor: it is the mean heartbeat
+   interval plus NEIGHBOR_DEV_K times its mean deviation, like TCP's
+   retransmission timeout, kept between NEIGHBOR_MIN_TIMEOUT and
+   NEIGHBOR_TIMEOUT. A larger K means fewer false suspicions and slower
+   detection.
+
+   On a lossy link only one heartbeat in ->avg_seqno_gap gets through,
+   so all of these timeouts are stretched by that gap, up to
+   NEIGHBOR_MAX_GAP times. The adaptive one also allows for the next
+   heartbeat being lost. */
+#define NEIGHBOR_TIMEOUT (90 * CLOCK_SECOND)
+#define NEIGHBOR_MIN_TIMEOUT (4 * CLOCK_SECOND)
+#define NEIGHBOR_MIN_SAMPLES 3
+#define NEIGHBOR_MAX_GAP 4
+
+#ifdef NEIGHBOR_TABLE_CONF_DEV_K
+#define NEIGHBOR_DEV_K NEIGHBOR_TABLE_CONF_DEV_K
+#else
+#define NEIGHBOR_DEV_K 4
+#endif
+
+/* This many missed pings are not held against a neighbor, since a
+   single lost frame says little about whether it is alive. Each one
+   after that counts as a missed heartbeat. */
+#ifdef NEIGHBOR_TABLE_CONF_FREE_MISSES
+#define NEIGHBOR_FREE_MISSES NEIGHBOR_TABLE_CONF_FREE_MISSES
+#else
+#define NEIGHBOR_FREE_MISSES 1
+#endif
+
+/* Neighbors restored from flash are provisional until we hear from
+   them again, and expire after this much time if we do not. */
+#define NEIGHBOR_PROVISIONAL_TIMEOUT (40 * CLOCK_SECOND)
+
+/* An expired neighbor may linger this much longer, so that the sweep
+   can share a wake-up with other scheduled work. */
+#define NEIGHBOR_SLACK (2 * CLOCK_SECOND)
+
+/* This structure holds information about neighbors. */
+struct neighbor {
+  /* The ->next pointer is needed since we are placing these on a
+     Contiki list. */
+  struct neighbor *next;
+
+  /* The ->addr field holds the Rime address of the neighbor. */
+  linkaddr_t addr;
+
+  /* The time we last heard from this neighbor. */
+  clock_time_t last_seen;
+
+  /* The time of its last heartbeat, if NEIGHBOR_BEAT is set. */
+  clock_time_t last_beat;
+
+  /* Each heartbeat contains a sequence number (seqno). The
+     ->last_seqno field holds the last sequenuce number we saw from
+     this neighbor. */
+  uint8_t last_seqno;
+
+  uint8_t flags;
+
+  /* Each unanswered ping counts as one missed heartbeat. */
+  uint8_t missed;
+
+  /* Heartbeat inter-arrival statistics: the number of samples, their
+     moving average and their moving mean deviation, in clock ticks. */
+  uint8_t samples;
+  uint16_t mean_interval;
+  uint16_t dev_interval;
+
+  /* The ->avg_seqno_gap field holds the average sequence number gap
+     of the broadcasts we got from this neighbor, as a link estimate. */
+  uint16_t avg_seqno_gap;
+};
+
+/* Neighbor flags. */
+#define NEIGHBOR_PROVISIONAL 0x01
+#define NEIGHBOR_BEAT        0x02
+/* Set by the node on neighbors that beaconed as a receiver. */
+#define NEIGHBOR_RECEIVER    0x04
+
+/* These two defines are used for computing the moving average for the
+   broadcast sequence number gaps. */
+#define SEQNO_EWMA_UNITY 0x100
+#define SEQNO_EWMA_ALPHA 0x040
+
+struct neighbor_table_callbacks {
+  /* Called when a neighbor is added to or removed from the table. */
+  void (* added)(struct neighbor *n);
+  void (* removed)(struct neighbor *n);
+};
+
+/* Initialize the table. The callbacks may be NULL. */
+void neighbor_table_init(const struct neighbor_table_callbacks *callbacks);
+
+/* Look up a neighbor, or return NULL if we do not know it. */
+struct neighbor *neighbor_table_find(const linkaddr_t *addr);
+
+/* Record a heartbeat from a neighbor, adding it to the table if it is
+   new. Returns NULL if the table is full. */
+struct neighbor *neighbor_table_add(const linkaddr_t *addr, uint8_t seqno);
+
+/* Record any other frame from a neighbor, such as a solicitation or
+   an advert, adding it to the table if it is new. The seqno is that of
+   the neighbor's last heartbeat. Returns NULL if the table is full. */
+struct neighbor *neighbor_table_heard(const linkaddr_t *addr, uint8_t seqno);
+
+/* Add a neighbor from a saved snapshot. It is marked provisional until
+   it is heard from again. Returns NULL if the table is full. */
+struct neighbor *neighbor_table_restore(const linkaddr_t *addr, uint8_t seqno,
+                                        uint16_t avg_seqno_gap);
+
+/* Mark a neighbor as confirmed, e.g. when it answered us. */
+void neighbor_table_confirm(const linkaddr_t *addr);
+
+/* Record that a neighbor did not answer us. Returns non-zero if this
+   made it fail, in which case it has been removed. */
+int neighbor_table_missed(const linkaddr_t *addr);
+
+/* Pick a random neighbor, or NULL if the table is empty. */
+struct neighbor *neighbor_table_random(void);
+
+int neighbor_table_length(void);
+
+/* The first neighbor in the table, for iterating with list_item_next(). */
+struct neighbor *neighbor_table_head(void);
+
+#endif /* NEIGHBOR_TABLE_H_ */
@@ -0,0 +1,289 @@
+#include "contiki.h"
+#include "net/rime/rime.h"
+#include "node.h"
+#include "neighbor-table.h"
+#if NODE_WITH_STORE
+#include "neighbor-store.h"
+#endif
+#include "task-sched.h"
+#include "tx-queue.h"
+#if NODE_WITH_TRACE
+#include "frame-trace.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+
+/* These hold the broadcast and unicast structures, respectively. */
+static struct broadcast_conn broadcast;
+static struct unicast_conn unicast;
+
+/* Beacons are sent from a task of the task scheduler, which merges them
+   with the other periodic work of the role. */
+static struct sched_task beacon_task;
+
+/* The sequence number of our last heartbeat. */
+static uint8_t seqno;
+
+static void send_beacon(void *ptr);
+#if NODE_ROLE == NODE_ROLE_SENDER
+static void send_solicit(void *ptr);
+
+/* Set from boot, and again whenever we solicit, until a receiver
+   answers. */
+static uint8_t soliciting;
+#endif
+
+/*---------------------------------------------------------------------------*/
+/* Snapshot the neighbor table to flash whenever its membership changes,
+   so that it can be restored after a reset. */
+static void
+neighbor_added(struct neighbor *n)
+{
+#if NODE_WITH_STORE
+  neighbor_store_changed();
+#endif
+}
+static void
+neighbor_removed(struct neighbor *n)
+{
+#if NODE_WITH_STORE
+  neighbor_store_changed();
+#endif
+#if NODE_ROLE == NODE_ROLE_SENDER
+  /* When the last receiver fails, look for a new one right away instead
+     of waiting for the next beacon. */
+  if(neighbor_table_length() == 0) {
+    sched_set_random(&beacon_task, 0, CLOCK_SECOND / 8, send_solicit, NULL);
+  }
+#endif
+}
+static const struct neighbor_table_callbacks neighbor_callbacks =
+  {neighbor_added, neighbor_removed};
+/*---------------------------------------------------------------------------*/
+/* Record a receiver we heard from. If we knew none and are soliciting,
+   it is told to the role, whether it answered with an advert, a reply
+   beacon or its next heartbeat. With neighbors restored from flash the
+   role reports right away, so it is not told again. */
+static struct neighbor *
+neighbor_heard(const linkaddr_t *from, uint8_t seqno, int heartbeat)
+{
+  struct neighbor *n;
+#if NODE_ROLE == NODE_ROLE_SENDER
+  int first;
+
+  first = neighbor_table_length() == 0;
+#endif
+  if(heartbeat) {
+    n = neighbor_table_add(from, seqno);
+  } else {
+    n = neighbor_table_heard(from, seqno);
+  }
+#if NODE_ROLE == NODE_ROLE_SENDER
+  if(n != NULL && soliciting) {
+    soliciting = 0;
+    if(first) {
+      node_role_joined(from);
+    }
+  }
+#endif
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+PROCESS(node_process, "Node process");
+/*---------------------------------------------------------------------------*/
+/* This function is called whenever a broadcast message is received. */
+static void
+broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from)
+{
+  struct broadcast_message *m;
+  struct neighbor *n;
+
+  /* The packetbuf_dataptr() returns a pointer to the first data byte
+     in the received packet. */
+  m = packetbuf_dataptr();
+#if NODE_WITH_TRACE
+  frame_trace_record(0, from, m, packetbuf_datalen());
+#endif
+  if(packetbuf_datalen() < sizeof(struct broadcast_message)) {
+    return;
+  }
+  node_role_broadcast_recv(from, m);
+
+  /* Beacons, solicitations and replies all tell us about a neighbor,
+     but only beacons are heartbeats. */
+  if(m->AC == 2 || m->AC == 3 || m->AC == 4) {
+#if NODE_ROLE == NODE_ROLE_SENDER
+    /* We only keep receivers as neighbors. Known neighbors are
+       refreshed, unknown ones are added if there is room. */
+    if(m->id == NODE_ROLE_SENDER && neighbor_table_find(from) == NULL) {
+      return;
+    }
+#endif
+    n = neighbor_heard(from, m->seqno, m->AC == 2);
+    if(n == NULL) {
+      return;
+    }
+    if(m->id == NODE_ROLE_RECEIVER) {
+      n->flags |= NEIGHBOR_RECEIVER;
+    }
+
+    /* Print out a message. */
+    printf("Broadcast message received from %d\n",
+           from->u8[0]);
+  }
+}
+/* This is where we define what function to be called when a broadcast
+   is received. We pass a pointer to this structure in the
+   broadcast_open() call below. */
+static const struct broadcast_callbacks broadcast_call = {broadcast_recv};
+/*---------------------------------------------------------------------------*/
+/* This function is called for every incoming unicast packet. */
+static void
+recv_uc(struct unicast_conn *c, const linkaddr_t *from)
+{
+  union {
+    struct unicast_message uc;
+    struct advert_message advert;
+    struct history_request request;
+    struct history_message history;
+  } msg;
+  uint16_t len;
+
+  /* Work on a copy, so that short packets read as zeros. */
+  memset(&msg, 0, sizeof(msg));
+  len = packetbuf_datalen();
+  memcpy(&msg, packetbuf_dataptr(), len < sizeof(msg) ? len : sizeof(msg));
+#if NODE_WITH_TRACE
+  frame_trace_record(FRAME_TRACE_UNICAST, from, packetbuf_dataptr(), len);
+#endif
+
+  /* Every ping is answered with a pong. */
+  if(msg.uc.type == UNICAST_TYPE_PING) {
+    msg.uc.type = UNICAST_TYPE_PONG;
+    node_unicast(TX_CLASS_ACK, from, &msg.uc, sizeof(struct unicast_message));
+    msg.uc.type = UNICAST_TYPE_PING;
+  }
+#if NODE_ROLE == NODE_ROLE_SENDER
+  /* An advert answers our solicitation for us alone. */
+  if(msg.uc.type == UNICAST_TYPE_ADVERT &&
+     msg.advert.id != NODE_ROLE_SENDER) {
+    neighbor_heard(from, msg.advert.seqno, 0);
+  }
+#endif
+  node_role_unicast_recv(from, &msg.uc, len);
+}
+static const struct unicast_callbacks unicast_callbacks = {recv_uc};
+/*---------------------------------------------------------------------------*/
+/* This function is called by the transmit queue, outside of any
+   receive callback, and is the only place that fills the packetbuf. */
+static void
+tx_send(const linkaddr_t *to, const void *data, uint8_t len)
+{
+  packetbuf_copyfrom(data, len);
+#if NODE_WITH_TRACE
+  frame_trace_record(FRAME_TRACE_TX | (to != NULL ? FRAME_TRACE_UNICAST : 0),
+                     to, data, len);
+#endif
+  if(to == NULL) {
+    broadcast_send(&broadcast);
+  } else {
+    unicast_send(&unicast, to);
+  }
+}
+static const struct tx_queue_callbacks tx_callbacks = {tx_send};
+/*---------------------------------------------------------------------------*/
+int
+node_broadcast(uint8_t class, const void *msg, uint8_t len)
+{
+  return tx_queue_send(class, NULL, msg, len);
+}
+/*---------------------------------------------------------------------------*/
+int
+node_unicast(uint8_t class, const linkaddr_t *to,
+             const void *msg, uint8_t len)
+{
+  return tx_queue_send(class, to, msg, len);
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+node_seqno(void)
+{
+  return seqno;
+}
+/*---------------------------------------------------------------------------*/
+void
+node_beacon(uint8_t kind)
+{
+  struct broadcast_message msg;
+
+  //id receiver = 1 , id sender/sensor = 0
+  msg.id = NODE_ROLE;
+  if(kind == 2) {
+    seqno++;
+  }
+  msg.seqno = seqno;
+  msg.AC = kind;
+  msg.zone = 0;
+  node_broadcast(TX_CLASS_DISCOVERY, &msg, sizeof(struct broadcast_message));
+}
+/*---------------------------------------------------------------------------*/
+/* Send a broadcast every 16 - 32 seconds */
+static void
+send_beacon(void *ptr)
+{
+  node_beacon(2);
+  sched_set_random(&beacon_task, NODE_BEACON_MIN, NODE_BEACON_MAX,
+                   send_beacon, NULL);
+}
+#if NODE_ROLE == NODE_ROLE_SENDER
+/* Solicit our neighbors once at boot, then fall back to beacons. The
+   short random delay spreads out motes that are powered up together. */
+static void
+send_solicit(void *ptr)
+{
+  soliciting = 1;
+  node_beacon(3);
+  sched_set_random(&beacon_task, NODE_BEACON_MIN, NODE_BEACON_MAX,
+                   send_beacon, NULL);
+}
+#endif
+/*---------------------------------------------------------------------------*/
+PROCESS_THREAD(node_process, ev, data)
+{
+  PROCESS_EXITHANDLER(broadcast_close(&broadcast); unicast_close(&unicast);)
+
+  PROCESS_BEGIN();
+
+#if NODE_WITH_TRACE
+  frame_trace_init(NODE_ROLE);
+#endif
+  tx_queue_init(&tx_callbacks);
+  broadcast_open(&broadcast, NODE_BROADCAST_CHANNEL, &broadcast_call);
+  unicast_open(&unicast, NODE_UNICAST_CHANNEL, &unicast_callbacks);
+
+  neighbor_table_init(&neighbor_callbacks);
+#if NODE_WITH_STORE
+  neighbor_store_init();
+#endif
+  node_role_init();
+
+#if NODE_ROLE == NODE_ROLE_SENDER
+  /* Ask the receivers around us to introduce themselves, rather than
+     waiting up to 32 s for their next beacon. */
+  soliciting = 1;
+  sched_set_random(&beacon_task, 0, CLOCK_SECOND / 8, send_solicit, NULL);
+#else
+  sched_set_random(&beacon_task, NODE_BEACON_MIN, NODE_BEACON_MAX,
+                   send_beacon, NULL);
+#endif
+
+  /* Everything else happens in callbacks, so there is nothing to wake
+     up for here. */
+  while(1) {
+    PROCESS_WAIT_EVENT();
+  }
+
+  PROCESS_END();
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,137 @@
+#ifndef NODE_H_
+#define NODE_H_
+
+#include "contiki.h"
+#include "net/rime/rime.h"
+#include "tx-queue.h"
+#include "sample-log.h"
+
+/* The firmware core shared by the receiver and the sender. Everything
+   that differs between them is selected at compile time, see the
+   variants in the Makefile. */
+
+/* The role is also the id a node puts in its broadcasts. */
+#define NODE_ROLE_SENDER   0
+#define NODE_ROLE_RECEIVER 1
+
+#ifdef NODE_CONF_ROLE
+#define NODE_ROLE NODE_CONF_ROLE
+#else
+#error "NODE_CONF_ROLE is not set, build one of the Makefile variants"
+#endif
+
+/* Whether the neighbor table is persisted to flash (neighbor-store.c).
+   Without it a reset starts over with an empty table. */
+#ifdef NODE_CONF_WITH_STORE
+#define NODE_WITH_STORE NODE_CONF_WITH_STORE
+#else
+#define NODE_WITH_STORE 1
+#endif
+
+#define NODE_BROADCAST_CHANNEL 129
+#define NODE_UNICAST_CHANNEL   146
+
+/* Whether every frame is recorded to a trace in flash (frame-trace.c),
+   for replaying it on the host. */
+#ifdef NODE_CONF_WITH_TRACE
+#define NODE_WITH_TRACE NODE_CONF_WITH_TRACE
+#else
+#define NODE_WITH_TRACE 0
+#endif
+
+/* Beacons are sent every 16 - 32 seconds. */
+#define NODE_BEACON_MIN (CLOCK_SECOND * 16)
+#define NODE_BEACON_MAX (CLOCK_SECOND * 32)
+
+/* This is the structure of broadcast messages. Beacons carry the number
+   of the last heartbeat in ->seqno, AC commands (0 and 1) carry the low
+   8 bits of the command epoch of their sender. These wrap every 256
+   commands, so two commands of one sender are ordered in serial number
+   arithmetic, (int8_t)(a - b) > 0, which holds while fewer than 128
+   commands lie between them. Receivers apply commands as they arrive
+   and do not order them. */
+struct broadcast_message {
+  uint8_t seqno;
+  uint8_t id;
+  uint8_t AC;	// 0->OFF;  1->ON;  2->IGNORE;  3->SOLICIT;  4->REPLY
+  uint8_t zone;
+};
+
+/* This is the structure of unicast ping messages. */
+struct unicast_message {
+  uint8_t type;
+  uint8_t temp;
+  /* The report period of the sender in seconds, 0 if unknown. Readings
+     are up to half a period late. */
+  uint8_t period;
+  /* The number of the reading. A retry keeps it, so that the reading
+     can be counted once. */
+  uint8_t seqno;
+};
+
+/* This is the structure of the unicast reply to a solicitation. */
+struct advert_message {
+  uint8_t type;
+  uint8_t id;
+  uint8_t seqno;
+};
+
+/* This is the structure of a request for the sample history of a
+   sensor. With ->all set the whole log is sent, otherwise the samples
+   from number ->since on. */
+struct history_request {
+  uint8_t type;
+  uint8_t all;
+  uint16_t since;
+};
+
+/* This is the structure of one block of sample history. Only the used
+   part of the block payload is sent. */
+struct history_message {
+  uint8_t type;
+  /* Non-zero on the last block of an upload. */
+  uint8_t last;
+  struct sample_block block;
+};
+
+/* These are the types of unicast messages that we can send. */
+enum {
+  UNICAST_TYPE_PING,
+  UNICAST_TYPE_PONG,
+  UNICAST_TYPE_ADVERT,
+  UNICAST_TYPE_HISTORY_REQUEST,
+  UNICAST_TYPE_HISTORY
+};
+
+PROCESS_NAME(node_process);
+
+/* Queue a message of a TX_CLASS_* class for the broadcast or the
+   unicast channel, see tx-queue.h. Returns zero if it was dropped. */
+int node_broadcast(uint8_t class, const void *msg, uint8_t len);
+int node_unicast(uint8_t class, const linkaddr_t *to,
+                 const void *msg, uint8_t len);
+
+/* Return the sequence number of our last heartbeat. Only the periodic
+   beacons are heartbeats and advance it, so that a neighbor can count
+   the ones it missed. Solicitations and replies carry it unchanged. */
+uint8_t node_seqno(void);
+
+/* Send a heartbeat beacon (AC = 2), a solicitation (AC = 3) or a
+   broadcast reply to solicitations (AC = 4). */
+void node_beacon(uint8_t kind);
+
+/* These are implemented by the role. node_role_init() is called once
+   the connections are open and the neighbor table is restored. The
+   receive hooks see every message before the core handles it. A
+   unicast message is zero padded, and len is its length on the air. */
+void node_role_init(void);
+void node_role_broadcast_recv(const linkaddr_t *from,
+                              const struct broadcast_message *m);
+void node_role_unicast_recv(const linkaddr_t *from,
+                            const struct unicast_message *m, uint16_t len);
+
+/* Sender only: called when a receiver answers our solicitation, by
+   advert or by broadcast, or is heard from while it is unanswered. */
+void node_role_joined(const linkaddr_t *from);
+
+#endif /* NODE_H_ */
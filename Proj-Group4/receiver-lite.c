@@ -0,0 +1,3 @@
+/* The receiver role, built with the small-RAM configuration of the
+   receiver-lite variant in the Makefile. */
+#include "receiver.c"
@@ -1,272 +1,446 @@
 #include "contiki.h"
-#include "lib/list.h"
-#include "lib/memb.h"
-#include "lib/random.h"
-#include "net/rime/rime.h"
 #include "dev/leds.h"
-
+#include "lib/list.h"
+#include "node.h"
+#include "ac-controller.h"
+#include "neighbor-table.h"
+#if NODE_WITH_STORE
+#include "neighbor-store.h"
+#endif
+#include "task-sched.h"
+#include "sample-log.h"
+
+#include <stddef.h>
 #include <stdio.h>
 
-/* AC flags, AC_BC is to know when AC was turned on by a bc message 
-	 AC_OFF_count is to only turn off AC because off sensores after 2 OFF messages */
-int AC = 0, AC_BC = 0, AC_OFF_count = 0;
-
-/* This is the structure of broadcast messages. */
-struct broadcast_message {
-  uint8_t seqno;
-  uint8_t id;	
-  uint8_t AC;	// 0->OFF;  1->ON;  2->IGNORE
-};
-
-/* This is the structure of unicast ping messages. */
-struct unicast_message {
-  uint8_t type;
-  uint8_t temp;
-};
-
-/* These are the types of unicast messages that we can send. */
-enum {
-  UNICAST_TYPE_PING,
-  UNICAST_TYPE_PONG
-};
-
-/* This structure holds information about neighbors. */
-struct neighbor {
-  /* The ->next pointer is needed since we are placing these on a
-     Contiki list. */
-  struct neighbor *next;
-
-  /* The ->addr field holds the Rime address of the neighbor. */
-  linkaddr_t addr;
-
-  struct ctimer ctimer;
-  /* Each broadcast packet contains a sequence number (seqno). The
-     ->last_seqno field holds the last sequenuce number we saw from
-     this neighbor. */
-  uint8_t last_seqno;
+/* Zones whose AC was turned on by a bc message from another receiver */
+static uint8_t ac_bc_zones;
+/* Zones whose AC we turned on with a bc message of our own. Only these
+   are turned off again by us, so that we do not clear a zone that
+   another receiver still holds on. */
+static uint8_t ac_announced_zones;
+
+/* Periodic work is run by the task scheduler, which coalesces it into
+   as few wake-ups as the windows allow. */
+static struct sched_task expire_task;
+static struct sched_task advert_task;
+
+/* Sensors that solicited us and are waiting for an advert. Replies are
+   delayed by a random time up to SOLICIT_JITTER. This spreads out the
+   answers of receivers that heard the same solicitation. Solicitations
+   that arrive within the delay are aggregated: if more than one sensor
+   is waiting by then, or some did not fit in the list, a single reply
+   beacon answers all of them instead of one advert each. A reply beacon
+   from another receiver answers them as well, so ours is dropped.
+   Adverts are unicast and cannot be overheard, so they do not suppress
+   each other. */
+#define SOLICIT_JITTER (CLOCK_SECOND / 2)
+#define SOLICIT_MAX_PENDING 4
+static linkaddr_t solicitors[SOLICIT_MAX_PENDING];
+static uint8_t solicitor_count, solicitor_overflow;
+
+#if !NODE_WITH_STORE
+static uint16_t epoch;
+#endif
 
- 
+/*---------------------------------------------------------------------------*/
+/* Sensor to zone assignment. Sensors that are not listed here go into
+   zone 0 with weight 1. */
+static const struct ac_zone_map zone_map[] = {
+  /* { { { 2, 0 } }, 1, 1 }, puts sensor 2.0 into zone 1 */
+  { { { 0, 0 } }, 0, 1 } /* linkaddr_null, never a sensor */
 };
 
-/* This #define defines the maximum amount of neighbors we can remember. */
-#define MAX_NEIGHBORS 16
-#define NEIGHBOR_TIMEOUT 90 * CLOCK_SECOND
+/* The decision policy of all zones, see ac-controller.h. */
+#ifdef RECEIVER_CONF_POLICY
+#define RECEIVER_POLICY RECEIVER_CONF_POLICY
+#else
+#define RECEIVER_POLICY AC_POLICY_MAX
+#endif
 
-/* This MEMB() definition defines a memory pool from which we allocate
-   neighbor entries. */
-MEMB(neighbors_memb, struct neighbor, MAX_NEIGHBORS);
+#ifdef RECEIVER_CONF_QUORUM
+#define RECEIVER_QUORUM RECEIVER_CONF_QUORUM
+#else
+#define RECEIVER_QUORUM 1
+#endif
 
-/* The neighbors_list is a Contiki list that holds the neighbors we
-   have seen thus far. */
-LIST(neighbors_list);
+/* Sweep out sensors that stopped reporting every 1/3 to 1/2 of the
+   sensor timeout. */
+#define EXPIRE_MIN (AC_CONTROLLER_SENSOR_TIMEOUT / 3 * CLOCK_SECOND)
+#define EXPIRE_MAX (AC_CONTROLLER_SENSOR_TIMEOUT / 2 * CLOCK_SECOND)
 
-/* These hold the broadcast and unicast structures, respectively. */
-static struct broadcast_conn broadcast;
-static struct unicast_conn unicast;
+static void
+update_leds(void)
+{
+  if(ac_controller_state() | ac_bc_zones) {
+    leds_on(LEDS_GREEN);
+  } else {
+    leds_off(LEDS_GREEN);
+  }
+}
 
-/* These two defines are used for computing the moving average for the
-   broadcast sequence number gaps. */
-#define SEQNO_EWMA_UNITY 0x100
-#define SEQNO_EWMA_ALPHA 0x040
+/* The sensors spread their readings over the receivers they know. The
+   receivers we know stand in for those, since the sensors hear the
+   same beacons. */
+static void
+expire_sensors(void *ptr)
+{
+  struct neighbor *n;
+  uint8_t receivers;
 
+  receivers = 1;
+  for(n = neighbor_table_head(); n != NULL; n = list_item_next(n)) {
+    if(n->flags & NEIGHBOR_RECEIVER) {
+      receivers++;
+    }
+  }
+  ac_controller_set_receivers(receivers);
+  ac_controller_expire();
+  sched_set(&expire_task, EXPIRE_MIN, EXPIRE_MAX, expire_sensors, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* The AUTOSTART_PROCESSES() definition specifices what processes to
+   start when this module is loaded. */
+AUTOSTART_PROCESSES(&node_process);
 /*---------------------------------------------------------------------------*/
-/*
- * This function is called by the ctimer present in each neighbor
- * table entry. The function removes the neighbor from the table
- * because it has become too old.
- */
+/* Answer the pending solicitations. */
 static void
-remove_neighbor(void *n)
+send_adverts(void *ptr)
 {
-  struct neighbor *e = n;
-  printf("Removed node %d from the list\n", e->addr);
-	leds_on(LEDS_RED);
-  list_remove(neighbors_list, e);
-  memb_free(&neighbors_memb, e);
+  struct advert_message msg;
+
+  if(solicitor_count > 1 || solicitor_overflow) {
+    node_beacon(4);
+  } else if(solicitor_count == 1) {
+    msg.type = UNICAST_TYPE_ADVERT;
+    msg.id = NODE_ROLE;
+    msg.seqno = node_seqno();
+    node_unicast(TX_CLASS_DISCOVERY, &solicitors[0], &msg,
+                 sizeof(struct advert_message));
+  }
+  solicitor_count = 0;
+  solicitor_overflow = 0;
 }
 
-/*---------------------------------------------------------------------------*/
-/* We first declare our two processes. */
-PROCESS(broadcast_process, "Broadcast process");
-PROCESS(unicast_process, "Unicast process");
+static void
+queue_advert(const linkaddr_t *from)
+{
+  uint8_t i;
 
-/* The AUTOSTART_PROCESSES() definition specifices what processes to
-   start when this module is loaded. We put both our processes
-   there. */
-AUTOSTART_PROCESSES(&broadcast_process, &unicast_process); // , &unicast_process
+  for(i = 0; i < solicitor_count; i++) {
+    if(linkaddr_cmp(&solicitors[i], from)) {
+      return;
+    }
+  }
+  if(solicitor_count < SOLICIT_MAX_PENDING) {
+    linkaddr_copy(&solicitors[solicitor_count++], from);
+  } else {
+    solicitor_overflow = 1;
+  }
+  if(!sched_pending(&advert_task)) {
+    sched_set_random(&advert_task, 0, SOLICIT_JITTER, send_adverts, NULL);
+  }
+}
 /*---------------------------------------------------------------------------*/
-/* This function is called whenever a broadcast message is received. */
+/* Broadcast the AC state of a zone to the other receivers. */
 static void
-broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from)
+announce(uint8_t zone, uint8_t on)
 {
-  struct neighbor *n;
-  struct broadcast_message *m;
-  //uint8_t seqno_gap;
-
-  /* The packetbuf_dataptr() returns a pointer to the first data byte
-     in the received packet. */
-  m = packetbuf_dataptr();
-	/* Ignore AC bc messages */
-	if(m->AC == 2){
-		/* Check if we already know this neighbor. */
-		for(n = list_head(neighbors_list); n != NULL; n = list_item_next(n)) {
-
-			/* We break out of the loop if the address of the neighbor matches
-				 the address of the neighbor from which we received this
-				 broadcast message. */
-			if(linkaddr_cmp(&n->addr, from)) {
-				/* Our neighbor was found, so we update the timeout. */
-				ctimer_set(&n->ctimer, NEIGHBOR_TIMEOUT, remove_neighbor, n);
-				break;
-			}
-		}
-
-		/* If n is NULL, this neighbor was not found in our list, and we
-			 allocate a new struct neighbor from the neighbors_memb memory
-			 pool. */
-		if(n == NULL) {
-			n = memb_alloc(&neighbors_memb);
-
-			/* If we could not allocate a new neighbor entry, we give up. We
-				 could have reused an old neighbor entry, but we do not do this
-				 for now. */
-			if(n == NULL) {
-				return;
-			}
-
-			/* Initialize the fields. */
-			linkaddr_copy(&n->addr, from);
-			n->last_seqno = m->seqno - 1;
-			ctimer_set(&n->ctimer, NEIGHBOR_TIMEOUT, remove_neighbor, n);
-		 
-
-			/* Place the neighbor on the neighbor list. */
-			list_add(neighbors_list, n);
-		}
-
-	/* Remember last seqno we heard. */
-		n->last_seqno = m->seqno;
-
-		/* Print out a message. */
-		printf("Broadcast message received from %d\n",
-					 from->u8[0]);
-	}else if(m->AC == 1){						
-		leds_on(LEDS_GREEN);
-		AC_BC = 1;
-	}else if(m->AC == 0){						
-		leds_off(LEDS_GREEN);
-		AC_BC = 0;
-	}
+  struct broadcast_message msg;
+
+  if(on) {
+    ac_announced_zones |= 1 << zone;
+  } else {
+    ac_announced_zones &= ~(1 << zone);
+  }
+  /* Number the commands with an epoch that survives resets. Only its
+     low 8 bits are sent, see struct broadcast_message. */
+#if NODE_WITH_STORE
+  msg.seqno = (uint8_t)neighbor_store_next_epoch();
+#else
+  msg.seqno = (uint8_t)++epoch;
+#endif
+  msg.id = NODE_ROLE;
+  msg.AC = on;
+  msg.zone = zone;
+  node_broadcast(TX_CLASS_CONTROL, &msg, sizeof(struct broadcast_message));
 }
-/* This is where we define what function to be called when a broadcast
-   is received. We pass a pointer to this structure in the
-   broadcast_open() call below. */
-static const struct broadcast_callbacks broadcast_call = {broadcast_recv};
 /*---------------------------------------------------------------------------*/
-/* This function is called for every incoming unicast packet. */
+/* This function is called whenever a broadcast message is received,
+   before the core adds the sender to the neighbor table. */
+void
+node_role_broadcast_recv(const linkaddr_t *from,
+                         const struct broadcast_message *m)
+{
+  /* Answer solicitations even if the neighbor table is full */
+  if(m->AC == 3) {
+    queue_advert(from);
+  } else if(m->AC == 4 && m->id == NODE_ROLE_RECEIVER) {
+    sched_stop(&advert_task);
+    solicitor_count = 0;
+    solicitor_overflow = 0;
+  } else if(m->AC == 1 && m->zone < AC_CONTROLLER_ZONES) {
+    ac_bc_zones |= 1 << m->zone;
+    update_leds();
+  } else if(m->AC == 0 && m->zone < AC_CONTROLLER_ZONES) {
+    ac_bc_zones &= ~(1 << m->zone);
+    update_leds();
+    /* The zone is still on here. Announce it again, so that the other
+       receivers keep it on, and turn it off later ourselves. */
+    if(ac_controller_state() & (1 << m->zone)) {
+      announce(m->zone, 1);
+    }
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* This function is called by the controller whenever the AC decision of
+   a zone changes. A zone is announced ON unless another receiver already
+   did, and OFF only if we announced it ON. */
 static void
-recv_uc(struct unicast_conn *c, const linkaddr_t *from)
+ac_changed(uint8_t zone, uint8_t on)
 {
-  struct unicast_message *msg;
-	struct broadcast_message msg2;
-
-  /* Grab the pointer to the incoming data. */
-  msg = packetbuf_dataptr();
-
-  /* We have two message types, UNICAST_TYPE_PING and
-     UNICAST_TYPE_PONG. If we receive a UNICAST_TYPE_PING message, we
-     print out a message and return a UNICAST_TYPE_PONG. */
-  if(msg->type == UNICAST_TYPE_PING) {
-    printf("Unicast received from %d -> TEMP = %d\n",
-           from->u8[0], msg->temp);
-    msg->type = UNICAST_TYPE_PONG;
-    packetbuf_copyfrom(msg, sizeof(struct unicast_message));		
-    /* Send it back to where it came from. */
-    unicast_send(c, from);
-		/* LEDS  */
-		if( msg->temp > 70){
-			AC_OFF_count = 0;
-			if(!AC && !AC_BC){				
-				leds_on(LEDS_GREEN);
-				AC = 1;
-				msg2.id = 1;
-				msg2.seqno = 0;
-				msg2.AC = 1;
-				packetbuf_copyfrom(&msg2, sizeof(struct broadcast_message));
-				broadcast_send(&broadcast);
-			}
-		}else{
-			AC_OFF_count++;
-			if(AC && AC_OFF_count == 3){
-				leds_off(LEDS_GREEN);
-				AC_OFF_count = 0;
-				AC = 0;
-				msg2.id = 1;
-				msg2.seqno = 0;
-				msg2.AC = 0;
-				packetbuf_copyfrom(&msg2, sizeof(struct broadcast_message));
-				broadcast_send(&broadcast);
-			}
-		}
+  printf("Zone %d AC %s\n", zone, on ? "ON" : "OFF");
+  update_leds();
+  if(on && !(ac_bc_zones & (1 << zone))) {
+    announce(zone, 1);
+  } else if(!on && (ac_announced_zones & (1 << zone))) {
+    announce(zone, 0);
   }
 }
-static const struct unicast_callbacks unicast_callbacks = {recv_uc};
+static const struct ac_controller_callbacks ac_callbacks = {ac_changed};
 /*---------------------------------------------------------------------------*/
+/* The history fetched from each sensor. The index of the next sample
+   is kept per sensor, so that an upload that skips a block, or stalls
+   before its last block, is asked again from there. A sensor that still
+   skips ahead after HISTORY_RETRIES requests no longer has the samples,
+   and one that does not answer that often is given up on. */
+#define HISTORY_SENSORS 8
+#define HISTORY_RETRIES 3
+#define HISTORY_STALL (4 * CLOCK_SECOND)
+
+#define HISTORY_VALID   0x01 /* next is a sample index of the sensor */
+#define HISTORY_ACTIVE  0x02 /* an upload is in progress */
+#define HISTORY_ALL     0x04 /* it was asked from the oldest sample */
+#define HISTORY_SYNCED  0x08 /* its first block has arrived */
+#define HISTORY_HEARD   0x10 /* a block arrived since the last check */
+
+struct history_state {
+  linkaddr_t addr;
+  uint16_t next;
+  uint8_t flags;
+  uint8_t retries;
+};
+static struct history_state histories[HISTORY_SENSORS];
+static uint8_t history_victim;
+static struct sched_task history_task;
 
-PROCESS_THREAD(broadcast_process, ev, data)
+static struct history_state *
+history_state(const linkaddr_t *addr, int add)
 {
-  static struct etimer et;
-  static uint8_t seqno;
-  struct broadcast_message msg;
+  struct history_state *h, *free;
+  uint8_t i;
+
+  free = NULL;
+  for(i = 0; i < HISTORY_SENSORS; i++) {
+    h = &histories[i];
+    if(linkaddr_cmp(&h->addr, addr)) {
+      return h;
+    }
+    if(free == NULL && linkaddr_cmp(&h->addr, &linkaddr_null)) {
+      free = h;
+    }
+  }
+  if(!add) {
+    return NULL;
+  }
+  /* Without a free slot, the slots are taken over in turn */
+  if(free == NULL) {
+    free = &histories[history_victim];
+    history_victim = (history_victim + 1) % HISTORY_SENSORS;
+  }
+  linkaddr_copy(&free->addr, addr);
+  free->flags = 0;
+  return free;
+}
 
-  PROCESS_EXITHANDLER(broadcast_close(&broadcast);)
+static void check_history(void *ptr);
 
-  PROCESS_BEGIN();
+/* Ask a sensor for its samples from the next index on, or for all of
+   them if we do not know where it is. */
+static void
+request_history(struct history_state *h)
+{
+  struct history_request msg;
+
+  msg.type = UNICAST_TYPE_HISTORY_REQUEST;
+  msg.all = !(h->flags & HISTORY_VALID);
+  msg.since = h->next;
+  h->flags = (h->flags & HISTORY_VALID) | HISTORY_ACTIVE | HISTORY_HEARD |
+    (msg.all ? HISTORY_ALL : 0);
+  node_unicast(TX_CLASS_TELEMETRY, &h->addr, &msg,
+               sizeof(struct history_request));
+  if(!sched_pending(&history_task)) {
+    sched_set(&history_task, HISTORY_STALL, HISTORY_STALL * 3 / 2,
+              check_history, NULL);
+  }
+}
 
-  broadcast_open(&broadcast, 129, &broadcast_call);
+/* Ask again for the uploads that stalled since the last check. */
+static void
+check_history(void *ptr)
+{
+  struct history_state *h;
+  uint8_t i, active;
+
+  active = 0;
+  for(i = 0; i < HISTORY_SENSORS; i++) {
+    h = &histories[i];
+    if(!(h->flags & HISTORY_ACTIVE)) {
+      continue;
+    }
+    if(!(h->flags & HISTORY_HEARD)) {
+      if(h->retries++ == HISTORY_RETRIES) {
+        printf("History from %d: no answer\n", h->addr.u8[0]);
+        h->flags &= ~HISTORY_ACTIVE;
+        continue;
+      }
+      /* A sensor that never answers from the index we know may have
+         been reset, which restarts its sample numbering. */
+      if(h->retries == HISTORY_RETRIES && !(h->flags & HISTORY_SYNCED)) {
+        h->flags &= ~HISTORY_VALID;
+      }
+      request_history(h);
+    }
+    h->flags &= ~HISTORY_HEARD;
+    active = 1;
+  }
+  if(active) {
+    sched_set(&history_task, HISTORY_STALL, HISTORY_STALL * 3 / 2,
+              check_history, NULL);
+  }
+}
 
-  while(1) {
+/* Fetch the history of a sensor. A sensor that timed out and came back
+   is only asked for the samples since its last upload. */
+static void
+fetch_history(const linkaddr_t *from)
+{
+  struct history_state *h;
 
-    /* Send a broadcast every 16 - 32 seconds */
-    etimer_set(&et, CLOCK_SECOND * 16 + random_rand() % (CLOCK_SECOND * 16));
+  h = history_state(from, 1);
+  h->retries = 0;
+  request_history(h);
+}
 
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+/* History blocks are decoded as they arrive, sample by sample, without
+   buffering the upload. Samples that were already decoded are skipped. */
+static uint8_t history_from;
+static uint16_t history_next;
 
-    //id receiver = 1 , id sender/sensor = 0
-    msg.id = 1;
-    msg.seqno = seqno;
-		msg.AC = 2;
-    packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
-    broadcast_send(&broadcast);
-    seqno++;
+static void
+history_sample(uint16_t index, int16_t value)
+{
+  if((int16_t)(index - history_next) < 0) {
+    return;
   }
-
-  PROCESS_END();
+  printf("History from %d: #%u %d/16\n", history_from, index, value);
 }
-/*---------------------------------------------------------------------------*/
 
-PROCESS_THREAD(unicast_process, ev, data)
+/* The header of a history message, up to the block payload. */
+#define HISTORY_HEADER_LEN \
+  (offsetof(struct history_message, block) + \
+   offsetof(struct sample_block, data))
+
+static void
+history_recv(const linkaddr_t *from, const struct history_message *m,
+             uint16_t len)
 {
-  PROCESS_EXITHANDLER(unicast_close(&unicast);)
-    
-  PROCESS_BEGIN();
-
-  unicast_open(&unicast, 146, &unicast_callbacks);
-
-  while(1) {
-    static struct etimer et;
-    struct unicast_message msg;
-    struct neighbor *n;
-    int randneighbor, i;
-    
-    etimer_set(&et, CLOCK_SECOND * 8 + random_rand() % (CLOCK_SECOND * 8));
-    
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  const struct sample_block *b;
+  struct history_state *h;
+  int n;
+
+  b = &m->block;
+  /* A block must arrive whole, or it would decode padding as samples. */
+  if(len < HISTORY_HEADER_LEN ||
+     b->nibbles > SAMPLE_LOG_BLOCK_SIZE * 2 ||
+     len < offsetof(struct history_message, block) + SAMPLE_BLOCK_LEN(b)) {
+    printf("History from %d: bad block length %u\n", from->u8[0], len);
+    return;
   }
-
-  PROCESS_END();
+  h = history_state(from, 0);
+  if(h == NULL || !(h->flags & HISTORY_ACTIVE)) {
+    return;
+  }
+  /* A full upload starts at the oldest sample the sensor still has */
+  if((h->flags & (HISTORY_ALL | HISTORY_SYNCED)) == HISTORY_ALL) {
+    h->next = b->index;
+  }
+  h->flags |= HISTORY_VALID | HISTORY_SYNCED | HISTORY_HEARD;
+  if((int16_t)(b->index - h->next) > 0) {
+    if(h->retries < HISTORY_RETRIES) {
+      printf("History from %d: missed #%u to #%u\n", from->u8[0], h->next,
+             b->index - 1);
+      h->retries++;
+      request_history(h);
+      return;
+    }
+    /* The sensor has dropped them from its log */
+    h->next = b->index;
+  }
+  history_from = from->u8[0];
+  history_next = h->next;
+  n = sample_log_decode(b, history_sample);
+  if(n < 0) {
+    printf("History from %d: bad block %u\n", from->u8[0], b->index);
+    return;
+  }
+  if((int16_t)(b->index + b->count - h->next) > 0) {
+    h->next = b->index + b->count;
+    h->retries = 0;
+  }
+  if(m->last) {
+    h->flags &= ~HISTORY_ACTIVE;
+  }
+  printf("History from %d: %d samples in %u bytes%s\n", from->u8[0], n,
+         (unsigned)SAMPLE_BLOCK_LEN(b), m->last ? ", done" : "");
 }
 /*---------------------------------------------------------------------------*/
+/* This function is called for every incoming unicast packet. The core
+   has already answered pings with a pong. */
+void
+node_role_unicast_recv(const linkaddr_t *from,
+                       const struct unicast_message *msg, uint16_t len)
+{
+  int known;
 
+  if(msg->type == UNICAST_TYPE_PING) {
+    printf("Unicast received from %d -> TEMP = %d, reading %u\n",
+           from->u8[0], msg->temp, msg->seqno);
+    /* Let the controller decide on the AC of the sensor's zone */
+    known = ac_controller_sensor(from) != NULL;
+    ac_controller_update(from, msg->temp, msg->period);
+    /* Fetch the history of a sensor that is new to the controller.
+       A sensor that did not fit in the table is not asked, or it would
+       be asked again on every ping. */
+    if(!known && ac_controller_sensor(from) != NULL) {
+      fetch_history(from);
+    }
+  }
+  if(msg->type == UNICAST_TYPE_HISTORY) {
+    history_recv(from, (const struct history_message *)msg, len);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+node_role_init(void)
+{
+  uint8_t z;
 
-
+  ac_controller_init(&ac_callbacks, zone_map,
+                     sizeof(zone_map) / sizeof(zone_map[0]));
+  for(z = 0; z < AC_CONTROLLER_ZONES; z++) {
+    ac_controller_set_policy(z, RECEIVER_POLICY, RECEIVER_QUORUM);
+  }
+  sched_set(&expire_task, EXPIRE_MIN, EXPIRE_MAX, expire_sensors, NULL);
+}
+/*---------------------------------------------------------------------------*/
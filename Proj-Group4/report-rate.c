@@ -0,0 +1,118 @@
+#include "contiki.h"
+#include "report-rate.h"
+#include "temp-sensor.h"
+
+#include <stdio.h>
+
+/* The slope is a moving average with a gain of 1 / 2^SLOPE_SHIFT. */
+#define SLOPE_SHIFT 2
+
+/* Acquisitions are made this many times per report period. */
+#define SAMPLES_PER_REPORT 4
+
+#define MINUTE (60L * CLOCK_SECOND)
+
+static const struct report_rate_callbacks *cb;
+
+static clock_time_t period;
+static int32_t slope;
+static int16_t last_temp;
+static clock_time_t last_time;
+static uint8_t primed;
+
+/*---------------------------------------------------------------------------*/
+/* The period for the current trend, before rounding. */
+static int32_t
+target_period(int16_t temp)
+{
+  int32_t distance;
+
+  distance = (int32_t)REPORT_RATE_THRESHOLD - temp;
+  if(slope == 0 || (distance > 0) != (slope > 0)) {
+    return REPORT_RATE_MAX;
+  }
+  if(distance < 0) {
+    distance = -distance;
+  }
+  /* The time until the threshold is reached, spread over STEPS
+     readings. */
+  return distance * MINUTE / (slope > 0 ? slope : -slope) / REPORT_RATE_STEPS;
+}
+/*---------------------------------------------------------------------------*/
+static void
+set_period(clock_time_t p)
+{
+  clock_time_t sample;
+
+  if(p == period) {
+    return;
+  }
+  period = p;
+  sample = period / SAMPLES_PER_REPORT;
+  temp_sensor_set_period(sample > TEMP_SENSOR_PERIOD ?
+                         sample : TEMP_SENSOR_PERIOD);
+  if(cb != NULL && cb->changed != NULL) {
+    cb->changed(period);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+report_rate_init(const struct report_rate_callbacks *callbacks)
+{
+  cb = callbacks;
+  period = REPORT_RATE_MAX;
+  slope = 0;
+  primed = 0;
+}
+/*---------------------------------------------------------------------------*/
+void
+report_rate_sampled(int16_t temp)
+{
+  clock_time_t now, p;
+  int32_t target;
+
+  now = clock_time();
+  if(!primed) {
+    primed = 1;
+  } else if(now != last_time) {
+    slope += ((int32_t)(temp - last_temp) * MINUTE /
+              (int32_t)(now - last_time) - slope) >> SLOPE_SHIFT;
+  }
+  last_temp = temp;
+  last_time = now;
+
+  /* Speed up at once, but slow down one step at a time, and only once
+     the trend allows for twice the slower period. */
+  target = target_period(temp);
+  for(p = REPORT_RATE_MIN; p < REPORT_RATE_MAX && p * 2 <= target; p *= 2);
+  if(p > REPORT_RATE_MAX) {
+    p = REPORT_RATE_MAX;
+  }
+  if(p > period) {
+    p = target >= (int32_t)period * 4 || period * 2 >= REPORT_RATE_MAX ?
+      period * 2 : period;
+    if(p > REPORT_RATE_MAX) {
+      p = REPORT_RATE_MAX;
+    }
+  }
+  set_period(p);
+}
+/*---------------------------------------------------------------------------*/
+clock_time_t
+report_rate_period(void)
+{
+  return period;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+report_rate_seconds(void)
+{
+  return (period + CLOCK_SECOND - 1) / CLOCK_SECOND;
+}
+/*---------------------------------------------------------------------------*/
+int32_t
+report_rate_slope(void)
+{
+  return slope;
+}
+/*---------------------------------------------------------------------------*/
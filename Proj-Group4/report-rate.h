@@ -0,0 +1,61 @@
+#ifndef REPORT_RATE_H_
+#define REPORT_RATE_H_
+
+#include "contiki.h"
+
+/* The report period of a sensor follows the trend of its filtered
+   temperature. While the temperature heads for the threshold, the
+   period is a fraction of the time left until it gets there, so that a
+   crossing is seen within a few readings. A flat temperature, or one
+   moving away from the threshold, is reported at the longest period.
+   The period is a power of two multiple of REPORT_RATE_MIN, which
+   keeps it stable under small changes of the trend. Acquisitions are
+   slowed down along with the reports. */
+
+#ifdef REPORT_RATE_CONF_MIN
+#define REPORT_RATE_MIN REPORT_RATE_CONF_MIN
+#else
+#define REPORT_RATE_MIN (2 * CLOCK_SECOND)
+#endif
+
+/* At most 255 seconds, as the period is sent in whole seconds. */
+#ifdef REPORT_RATE_CONF_MAX
+#define REPORT_RATE_MAX REPORT_RATE_CONF_MAX
+#else
+#define REPORT_RATE_MAX (64 * CLOCK_SECOND)
+#endif
+
+/* The threshold, in 1/16 degree like the filtered temperature. */
+#ifdef REPORT_RATE_CONF_THRESHOLD
+#define REPORT_RATE_THRESHOLD REPORT_RATE_CONF_THRESHOLD
+#else
+#define REPORT_RATE_THRESHOLD (70 << 4)
+#endif
+
+/* The number of readings to send before a trend reaches the
+   threshold. */
+#ifdef REPORT_RATE_CONF_STEPS
+#define REPORT_RATE_STEPS REPORT_RATE_CONF_STEPS
+#else
+#define REPORT_RATE_STEPS 4
+#endif
+
+struct report_rate_callbacks {
+  /* Called when the period changes. */
+  void (*changed)(clock_time_t period);
+};
+
+void report_rate_init(const struct report_rate_callbacks *callbacks);
+
+/* Feed a new filtered temperature, see temp-sensor.h. This has the
+   signature of the sampled() callback of the temperature sensor. */
+void report_rate_sampled(int16_t temp);
+
+/* The current report period, in ticks and in whole seconds. */
+clock_time_t report_rate_period(void);
+uint8_t report_rate_seconds(void);
+
+/* The trend of the temperature, in 1/16 degree per minute. */
+int32_t report_rate_slope(void);
+
+#endif /* REPORT_RATE_H_ */
@@ -0,0 +1,67 @@
+#include "contiki.h"
+#include "sample-log.h"
+
+/* The decoder is kept apart from the log, so that receivers link it
+   without the RAM of the log. */
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+get_nibble(const struct sample_block *b, uint8_t pos)
+{
+  return (pos & 1) ? b->data[pos / 2] >> 4 : b->data[pos / 2] & 0x0f;
+}
+/*---------------------------------------------------------------------------*/
+/* Read a varint at *pos. Returns zero if it runs past the end of the
+   block. */
+static int
+get_varint(const struct sample_block *b, uint8_t *pos, uint16_t *v)
+{
+  uint8_t nibble, shift;
+
+  *v = 0;
+  for(shift = 0; *pos < b->nibbles && shift < 16; shift += 3) {
+    nibble = get_nibble(b, (*pos)++);
+    *v |= (uint16_t)(nibble & 7) << shift;
+    if(!(nibble & 8)) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
+int
+sample_log_decode(const struct sample_block *b,
+                  void (*sample)(uint16_t index, int16_t value))
+{
+  uint16_t code, run, n;
+  uint8_t pos;
+  int16_t value;
+
+  if(b->count == 0 || b->nibbles > SAMPLE_LOG_BLOCK_SIZE * 2) {
+    return -1;
+  }
+  value = b->first;
+  sample(b->index, value);
+  n = 1;
+  pos = 0;
+  while(pos < b->nibbles) {
+    if(!get_varint(b, &pos, &code)) {
+      return -1;
+    }
+    if(code == 0) {
+      /* A run of zero deltas repeats the last value. */
+      if(!get_varint(b, &pos, &run)) {
+        return -1;
+      }
+      for(run++; run > 0 && n < b->count; run--, n++) {
+        sample(b->index + n, value);
+      }
+    } else if(n < b->count) {
+      value += (int16_t)((code >> 1) ^ -(code & 1));
+      sample(b->index + n, value);
+      n++;
+    }
+  }
+  return n == b->count ? n : -1;
+}
+/*---------------------------------------------------------------------------*/
@@ -0,0 +1,156 @@
+#include "contiki.h"
+#include "sample-log.h"
+
+#include <string.h>
+
+#define CAPACITY (SAMPLE_LOG_BLOCK_SIZE * 2)
+#define NO_RUN 0xff
+
+/* The ring of blocks. head is the oldest block, and the newest one is
+   the one being filled. */
+static struct sample_block blocks[SAMPLE_LOG_BLOCKS];
+static uint8_t head, used;
+
+static int16_t last;
+static uint16_t next_index;
+
+/* Where the zero run at the end of the newest block starts, and its
+   length, so that it can be extended in place. */
+static uint8_t run_pos, run_len;
+
+/*---------------------------------------------------------------------------*/
+static uint8_t
+varint_nibbles(uint16_t v)
+{
+  uint8_t n;
+
+  for(n = 1; v >= 8; n++) {
+    v >>= 3;
+  }
+  return n;
+}
+/*---------------------------------------------------------------------------*/
+static void
+put_nibble(struct sample_block *b, uint8_t pos, uint8_t nibble)
+{
+  if(pos & 1) {
+    b->data[pos / 2] = (b->data[pos / 2] & 0x0f) | (nibble << 4);
+  } else {
+    b->data[pos / 2] = (b->data[pos / 2] & 0xf0) | nibble;
+  }
+}
+/*---------------------------------------------------------------------------*/
+static uint8_t
+put_varint(struct sample_block *b, uint8_t pos, uint16_t v)
+{
+  while(v >= 8) {
+    put_nibble(b, pos++, (v & 7) | 8);
+    v >>= 3;
+  }
+  put_nibble(b, pos++, v);
+  return pos;
+}
+/*---------------------------------------------------------------------------*/
+static struct sample_block *
+newest(void)
+{
+  return &blocks[(head + used - 1) % SAMPLE_LOG_BLOCKS];
+}
+/*---------------------------------------------------------------------------*/
+/* Start a new block with a full sample. */
+static void
+start_block(int16_t sample)
+{
+  struct sample_block *b;
+
+  if(used < SAMPLE_LOG_BLOCKS) {
+    used++;
+  } else {
+    head = (head + 1) % SAMPLE_LOG_BLOCKS;
+  }
+  b = newest();
+  b->index = next_index;
+  b->first = sample;
+  b->count = 1;
+  b->nibbles = 0;
+  memset(b->data, 0, sizeof(b->data));
+  run_pos = NO_RUN;
+}
+/*---------------------------------------------------------------------------*/
+void
+sample_log_init(void)
+{
+  head = 0;
+  used = 0;
+  next_index = 0;
+  run_pos = NO_RUN;
+}
+/*---------------------------------------------------------------------------*/
+void
+sample_log_add(int16_t sample)
+{
+  struct sample_block *b;
+  uint16_t code;
+  int16_t delta;
+
+  if(used == 0) {
+    start_block(sample);
+  } else {
+    b = newest();
+    delta = sample - last;
+    if(b->count == 255) {
+      start_block(sample);
+    } else if(delta == 0) {
+      /* Extend the zero run, or start one. */
+      if(run_pos == NO_RUN) {
+        if(b->nibbles + 2 > CAPACITY) {
+          start_block(sample);
+        } else {
+          run_pos = b->nibbles;
+          run_len = 1;
+          b->nibbles = put_varint(b, put_varint(b, run_pos, 0), 0);
+          b->count++;
+        }
+      } else if(run_pos + 1 + varint_nibbles(run_len) > CAPACITY) {
+        start_block(sample);
+      } else {
+        b->nibbles = put_varint(b, put_varint(b, run_pos, 0), run_len);
+        run_len++;
+        b->count++;
+      }
+    } else {
+      code = ((uint16_t)delta << 1) ^ (uint16_t)(delta >> 15);
+      if(b->nibbles + varint_nibbles(code) > CAPACITY) {
+        start_block(sample);
+      } else {
+        b->nibbles = put_varint(b, b->nibbles, code);
+        b->count++;
+        run_pos = NO_RUN;
+      }
+    }
+  }
+  last = sample;
+  next_index++;
+}
+/*---------------------------------------------------------------------------*/
+const struct sample_block *
+sample_log_find(uint16_t since)
+{
+  struct sample_block *b;
+  uint8_t i;
+
+  for(i = 0; i < used; i++) {
+    b = &blocks[(head + i) % SAMPLE_LOG_BLOCKS];
+    if((int16_t)(b->index + b->count - since) > 0) {
+      return b;
+    }
+  }
+  return NULL;
+}
+/*---------------------------------------------------------------------------*/
+const struct sample_block *
+sample_log_oldest(void)
+{
+  return used > 0 ? &blocks[head] : NULL;
+}
+/*---------------------------------------------------------------------------*/
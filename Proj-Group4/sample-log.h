@@ -0,0 +1,70 @@
+#ifndef SAMPLE_LOG_H_
+#define SAMPLE_LOG_H_
+
+#include "contiki.h"
+
+/* The sample log keeps the recent temperature history of a sensor in a
+   ring of blocks in RAM. Each block starts with a full sample, and
+   holds the following samples as deltas to their predecessor:
+
+   - a delta d != 0 is stored as the zig-zag code (d << 1) ^ (d >> 15),
+   - a run of n zero deltas is stored as the code 0 followed by n - 1,
+
+   each code as a varint of 4-bit groups, 3 data bits and a
+   continuation bit, low group first. A slowly varying temperature thus
+   costs 4 bits per sample or less, instead of 16. Every block decodes
+   on its own, so blocks can be uploaded and decoded one at a time. */
+
+/* The number of payload bytes of a block, which also bounds the size
+   of a history message. */
+#ifdef SAMPLE_LOG_CONF_BLOCK_SIZE
+#define SAMPLE_LOG_BLOCK_SIZE SAMPLE_LOG_CONF_BLOCK_SIZE
+#else
+#define SAMPLE_LOG_BLOCK_SIZE 16
+#endif
+
+#ifdef SAMPLE_LOG_CONF_BLOCKS
+#define SAMPLE_LOG_BLOCKS SAMPLE_LOG_CONF_BLOCKS
+#else
+#define SAMPLE_LOG_BLOCKS 8
+#endif
+
+/* How often a sample is logged. */
+#ifdef SAMPLE_LOG_CONF_PERIOD
+#define SAMPLE_LOG_PERIOD SAMPLE_LOG_CONF_PERIOD
+#else
+#define SAMPLE_LOG_PERIOD (10 * CLOCK_SECOND)
+#endif
+
+struct sample_block {
+  /* The number of the first sample since boot. */
+  uint16_t index;
+  int16_t first;
+  uint8_t count;
+  uint8_t nibbles;
+  uint8_t data[SAMPLE_LOG_BLOCK_SIZE];
+};
+
+/* The size of a block with only the used part of its payload. */
+#define SAMPLE_BLOCK_LEN(b) \
+  (sizeof(struct sample_block) - SAMPLE_LOG_BLOCK_SIZE + \
+   ((b)->nibbles + 1) / 2)
+
+void sample_log_init(void);
+
+/* Append a sample to the log, dropping the oldest block if needed. */
+void sample_log_add(int16_t sample);
+
+/* Return the oldest block that holds samples from index since on, or
+   NULL if there is none. */
+const struct sample_block *sample_log_find(uint16_t since);
+
+/* Return the oldest block in the log, or NULL if it is empty. */
+const struct sample_block *sample_log_oldest(void);
+
+/* Decode a block, calling sample() for each of its samples in order.
+   Returns the number of samples, or -1 if the block is malformed. */
+int sample_log_decode(const struct sample_block *b,
+                      void (*sample)(uint16_t index, int16_t value));
+
+#endif /* SAMPLE_LOG_H_ */
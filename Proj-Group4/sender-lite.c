@@ -0,0 +1,3 @@
+/* The sender role, built with the small-RAM configuration of the
+   sender-lite variant in the Makefile. */
+#include "sender.c"
@@ -0,0 +1,3 @@
+/* The sender role, built for the NTC bridge of the sender-ntc
+   variant in the Makefile. */
+#include "sender.c"
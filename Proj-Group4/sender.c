@@ -1,292 +1,298 @@
 #include "contiki.h"
-#include "lib/list.h"
-#include "lib/memb.h"
-#include "lib/random.h"
-#include "net/rime/rime.h"
 #include "dev/leds.h"
-#include "pt.h"
-
+#include "lib/list.h"
+#include "node.h"
+#include "neighbor-table.h"
+#include "task-sched.h"
+#include "temp-sensor.h"
+#include "sample-log.h"
+#include "report-rate.h"
+
+#include <stddef.h>
 #include <stdio.h>
 
-#define RATE 3.27
-#define MINTEMP 40
-
-int temp_idx = 0;
-
-/* This is the structure of broadcast messages. */
-struct broadcast_message {
-  uint8_t seqno;
-  uint8_t id;
-  uint8_t AC;	// 0->OFF;  1->ON;  2->IGNORE
-};
-
-/* This is the structure of unicast ping messages. */
-struct unicast_message {
-  uint8_t type;
-  uint8_t temp;
-};
+/* The temperature driver, see temp-sensor.h. The trace driver replays
+   temp.trace if there is one, and is a synthetic ramp otherwise. */
+#ifdef SENDER_CONF_TEMP_DRIVER
+#define SENDER_TEMP_DRIVER SENDER_CONF_TEMP_DRIVER
+#else
+#define SENDER_TEMP_DRIVER temp_trace_driver
+#endif
+
+/* The readings are sent from a task of the task scheduler, which merges
+   them with the beacons into shared wake-ups when their windows
+   overlap. They are sent every report period of report-rate.c, up to
+   half a period late. While we know no receiver, we look again every
+   RETRY_MIN - RETRY_MAX instead. */
+#define RETRY_MIN (CLOCK_SECOND * 8)
+#define RETRY_MAX (CLOCK_SECOND * 16)
+static struct sched_task reading_task;
+static clock_time_t reading_time;
+static clock_time_t report_period = REPORT_RATE_MAX;
+
+/* The blue LED is lit for half a second for every ACK. */
+static struct sched_task blink_task;
+
+/* A receiver that does not answer a reading with a PONG within
+   PONG_TIMEOUT has missed a heartbeat. The reading is then sent once
+   more, to another receiver if we know one. */
+#define PONG_TIMEOUT CLOCK_SECOND
+static struct sched_task pong_task;
+static linkaddr_t ping_addr;
+static uint8_t ping_temp;
+static uint8_t ping_seqno;
+static uint8_t ping_retried;
+
+/* The filtered temperature is logged every SAMPLE_LOG_PERIOD, and the
+   log is uploaded one block at a time on request. */
+#define UPLOAD_GAP (CLOCK_SECOND / 4)
+static struct sched_task log_task;
+static struct sched_task upload_task;
+static linkaddr_t upload_addr;
+static uint16_t upload_since;
 
-
-/* These are the types of unicast messages that we can send. */
-enum {
-  UNICAST_TYPE_PING,
-  UNICAST_TYPE_PONG
-};
-
-static int
-temperature(void)
+/*---------------------------------------------------------------------------*/
+/* The AUTOSTART_PROCESSES() definition specifices what processes to
+   start when this module is loaded. */
+AUTOSTART_PROCESSES(&node_process);
+/*---------------------------------------------------------------------------*/
+static void
+blue_off(void *ptr)
 {
-  if(temp_idx * RATE + MINTEMP >= 100){
-    temp_idx = 0;
-  }
-  else{
-    temp_idx++;
-  }
-  return temp_idx * RATE + MINTEMP;
+  leds_off(LEDS_BLUE);
 }
-
-/* This structure holds information about neighbors. */
-struct neighbor {
-  /* The ->next pointer is needed since we are placing these on a
-     Contiki list. */
-  struct neighbor *next;
-
-  /* The ->addr field holds the Rime address of the neighbor. */
-  linkaddr_t addr;
-  struct ctimer ctimer;
-  /* Each broadcast packet contains a sequence number (seqno). The
-     ->last_seqno field holds the last sequenuce number we saw from
-     this neighbor. */
-  uint8_t last_seqno;
-
-};
-
-/* This #define defines the maximum amount of neighbors we can remember. */
-#define MAX_NEIGHBORS 16
-#define NEIGHBOR_TIMEOUT 90 * CLOCK_SECOND
-
-/* This MEMB() definition defines a memory pool from which we allocate
-   neighbor entries. */
-MEMB(neighbors_memb, struct neighbor, MAX_NEIGHBORS);
-
-/* The neighbors_list is a Contiki list that holds the neighbors we
-   have seen thus far. */
-LIST(neighbors_list);
-
-/* These hold the broadcast and unicast structures, respectively. */
-static struct broadcast_conn broadcast;
-static struct unicast_conn unicast;
-
-/* These two defines are used for computing the moving average for the
-   broadcast sequence number gaps. */
-#define SEQNO_EWMA_UNITY 0x100
-#define SEQNO_EWMA_ALPHA 0x040
-
 /*---------------------------------------------------------------------------*/
-/*
- * This function is called by the ctimer present in each neighbor
- * table entry. The function removes the neighbor from the table
- * because it has become too old.
- */
+/* The green LED shows whether the filtered temperature is above 70. */
 static void
-remove_neighbor(void *n)
+temp_sampled(int16_t temp)
 {
-  struct neighbor *e = n;
-  printf("Removed node %d from the list\n", e->addr);
-	leds_on(LEDS_RED);
-  list_remove(neighbors_list, e);
-  memb_free(&neighbors_memb, e);
+  report_rate_sampled(temp);
+  if(temp > (70 << TEMP_SENSOR_SHIFT)) {
+    leds_on(LEDS_GREEN);
+  } else {
+    leds_off(LEDS_GREEN);
+  }
 }
-
+static const struct temp_sensor_callbacks temp_callbacks = {temp_sampled};
 /*---------------------------------------------------------------------------*/
-/* We first declare our two processes. */
-PROCESS(broadcast_process, "Broadcast process");
-PROCESS(unicast_process, "Unicast process");
-PROCESS(blue_blink, "Blink blue LED");
-
-/* The AUTOSTART_PROCESSES() definition specifices what processes to
-   start when this module is loaded. We put both our processes
-   there. */
-AUTOSTART_PROCESSES(&broadcast_process, &unicast_process);
+void
+node_role_broadcast_recv(const linkaddr_t *from,
+                         const struct broadcast_message *m)
+{
+  /* Beacons are handled by the core, and AC commands are for the
+     receivers. */
+}
 /*---------------------------------------------------------------------------*/
-/* This function is called whenever a broadcast message is received. */
 static void
-broadcast_recv(struct broadcast_conn *c, const linkaddr_t *from)
+log_sample(void *ptr)
 {
-  struct neighbor *n;
-  struct broadcast_message *m;
-  //uint8_t seqno_gap;
-
-  /* The packetbuf_dataptr() returns a pointer to the first data byte
-     in the received packet. */
-  m = packetbuf_dataptr();
-	/* Ignore AC bc messages */
-	if(m->AC == 2){
-		/* Check if we already know this neighbor. */
-		for(n = list_head(neighbors_list); n != NULL; n = list_item_next(n)) {
-
-			/* We break out of the loop if the address of the neighbor matches
-				 the address of the neighbor from which we received this
-				 broadcast message. */
-			if(linkaddr_cmp(&n->addr, from)) {
-				/* Our neighbor was found, so we update the timeout. */
-				ctimer_set(&n->ctimer, NEIGHBOR_TIMEOUT, remove_neighbor, n);
-				break;
-			}
-		}
-
-		/* If n is NULL, this neighbor was not found in our list, and we
-			 allocate a new struct neighbor from the neighbors_memb memory
-			 pool. */
-		if(n == NULL) {
-			if(m->id == 0){
-				return;
-			}else{
-				n = memb_alloc(&neighbors_memb);
-
-				/* If we could not allocate a new neighbor entry, we give up. We
-					 could have reused an old neighbor entry, but we do not do this
-					 for now. */
-				if(n == NULL) {
-					return;
-				}
+  if(temp_sensor_value() != TEMP_SENSOR_INVALID) {
+    sample_log_add(temp_sensor_value());
+  }
+  sched_set(&log_task, SAMPLE_LOG_PERIOD, SAMPLE_LOG_PERIOD, log_sample, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Send the next block of an upload. Blocks are spaced out, so that the
+   upload does not crowd the readings out of the queue. A block that is
+   dropped or lost is not resent, the receiver can ask again for the
+   samples it misses. */
+static void
+upload_block(void *ptr)
+{
+  struct history_message msg;
+  const struct sample_block *b;
 
-				/* Initialize the fields. */
-				linkaddr_copy(&n->addr, from);
-				n->last_seqno = m->seqno - 1;
-		 
-				
-				ctimer_set(&n->ctimer, NEIGHBOR_TIMEOUT, remove_neighbor, n);
-				/* Place the neighbor on the neighbor list. */
-				list_add(neighbors_list, n);
-			}
-		}
+  b = sample_log_find(upload_since);
+  if(b == NULL) {
+    return;
+  }
+  msg.type = UNICAST_TYPE_HISTORY;
+  msg.block = *b;
+  upload_since = b->index + b->count;
+  msg.last = sample_log_find(upload_since) == NULL;
+  node_unicast(TX_CLASS_TELEMETRY, &upload_addr, &msg,
+               offsetof(struct history_message, block) + SAMPLE_BLOCK_LEN(b));
+  if(!msg.last) {
+    sched_set(&upload_task, UPLOAD_GAP, UPLOAD_GAP, upload_block, NULL);
+  }
+}
 
-		/* Remember last seqno we heard. */
-		n->last_seqno = m->seqno;
+/* A receiver asked for our sample history. A new request replaces the
+   upload in progress. */
+static void
+history_request_recv(const linkaddr_t *from, const struct history_request *m)
+{
+  const struct sample_block *b;
 
-		/* Print out a message. */
-		printf("Broadcast message received from %d\n",
-					 from->u8[0]);
-	}
+  printf("History request from %d\n", from->u8[0]);
+  if(m->all) {
+    b = sample_log_oldest();
+    if(b == NULL) {
+      return;
+    }
+    upload_since = b->index;
+  } else {
+    upload_since = m->since;
+  }
+  linkaddr_copy(&upload_addr, from);
+  sched_set(&upload_task, 0, UPLOAD_GAP, upload_block, NULL);
 }
-/* This is where we define what function to be called when a broadcast
-   is received. We pass a pointer to this structure in the
-   broadcast_open() call below. */
-static const struct broadcast_callbacks broadcast_call = {broadcast_recv};
 /*---------------------------------------------------------------------------*/
+static void send_reading(void *ptr);
 
-/* Process to blink the blue led for half a second */
-PROCESS_THREAD(blue_blink, ev, data) {
- 			PROCESS_BEGIN();
- 			static struct etimer et;
-			leds_on(LEDS_BLUE);		
-			etimer_set(&et, CLOCK_SECOND / 2);
-			PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
-			leds_off(LEDS_BLUE);
- 			PROCESS_END();
- 		}
-
-
-/* This function is called for every incoming unicast packet. */
+/* A receiver answered our solicitation. The core has added it to the
+   neighbor table. */
 static void
-recv_uc(struct unicast_conn *c, const linkaddr_t *from)
+advert_recv(const linkaddr_t *from, const struct advert_message *m)
 {
-  struct unicast_message *msg;
+  printf("Advert received from %d\n", from->u8[0]);
+}
 
-  /* Grab the pointer to the incoming data. */
-  msg = packetbuf_dataptr();
+/* The first receiver answered our solicitation, so send the first
+   reading right away instead of waiting out the report period. */
+void
+node_role_joined(const linkaddr_t *from)
+{
+  sched_set(&reading_task, 0, CLOCK_SECOND / 8, send_reading, NULL);
+}
 
-  /* We have two message types, UNICAST_TYPE_PING and
-     UNICAST_TYPE_PONG. If we receive a UNICAST_TYPE_PING message, we
-     print out a message and return a UNICAST_TYPE_PONG. */
+/* This function is called for every incoming unicast packet. The core
+   has already answered pings with a pong. */
+void
+node_role_unicast_recv(const linkaddr_t *from,
+                       const struct unicast_message *msg, uint16_t len)
+{
   if(msg->type == UNICAST_TYPE_PING) {
     printf("Unicast ping received from %d\n",
            from->u8[0]);
-    msg->type = UNICAST_TYPE_PONG;
-    packetbuf_copyfrom(msg, sizeof(struct unicast_message));
-    /* Send it back to where it came from. */
-    unicast_send(c, from);
+  }
+  if(msg->type == UNICAST_TYPE_ADVERT) {
+    advert_recv(from, (const struct advert_message *)msg);
+  }
+  if(msg->type == UNICAST_TYPE_HISTORY_REQUEST) {
+    history_request_recv(from, (const struct history_request *)msg);
   }
   if(msg->type == UNICAST_TYPE_PONG) {
     printf("Unicast ACK received from %d\n", from->u8[0]);
-		process_start(&blue_blink, NULL);
+    /* A neighbor restored from flash is alive after all */
+    neighbor_table_confirm(from);
+    if(linkaddr_cmp(from, &ping_addr)) {
+      sched_stop(&pong_task);
+    }
+    leds_on(LEDS_BLUE);
+    sched_set(&blink_task, CLOCK_SECOND / 2, CLOCK_SECOND / 2, blue_off,
+              NULL);
   }
 }
-
-static const struct unicast_callbacks unicast_callbacks = {recv_uc};
 /*---------------------------------------------------------------------------*/
-PROCESS_THREAD(broadcast_process, ev, data)
-{
-  static struct etimer et;
-  static uint8_t seqno;
-  struct broadcast_message msg;
-
-  PROCESS_EXITHANDLER(broadcast_close(&broadcast);)
-
-  PROCESS_BEGIN();
-
-  broadcast_open(&broadcast, 129, &broadcast_call);
-
-  while(1) {
+static void pong_timeout(void *ptr);
 
-    /* Send a broadcast every 16 - 32 seconds */
-    etimer_set(&et, CLOCK_SECOND * 16 + random_rand() % (CLOCK_SECOND * 16));
-
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
-
-    //id receiver = 1 , id sender/sensor = 0
-    msg.id = 0;
-    msg.seqno = seqno;
-		msg.AC = 2;
-    packetbuf_copyfrom(&msg, sizeof(struct broadcast_message));
-    broadcast_send(&broadcast);
-    seqno++;
+static void
+send_ping(const linkaddr_t *to, uint8_t temp)
+{
+  struct unicast_message msg;
+
+  printf("Sending unicast to %d -> Temp = %d, reading %u\n", to->u8[0], temp,
+         ping_seqno);
+  msg.temp = temp;
+  msg.type = UNICAST_TYPE_PING;
+  msg.period = report_rate_seconds();
+  msg.seqno = ping_seqno;
+  if(!node_unicast(TX_CLASS_TELEMETRY, to, &msg, sizeof(msg))) {
+    return;
   }
 
-  PROCESS_END();
+  /* The PONG timeout includes the time the PING waits in the queue. */
+  linkaddr_copy(&ping_addr, to);
+  ping_temp = temp;
+  sched_set(&pong_task, PONG_TIMEOUT, PONG_TIMEOUT, pong_timeout, NULL);
 }
 /*---------------------------------------------------------------------------*/
-PROCESS_THREAD(unicast_process, ev, data)
+/* The receiver did not answer. Record the miss, which may make the
+   failure detector give up on it unless it is the first in a row, and
+   reroute the reading. */
+static void
+pong_timeout(void *ptr)
 {
-  PROCESS_EXITHANDLER(unicast_close(&unicast);)
-    
-  PROCESS_BEGIN();
-
-  unicast_open(&unicast, 146, &unicast_callbacks);
+  struct neighbor *n;
 
-  while(1) {
-    static struct etimer et;
-    struct unicast_message msg;
-    struct neighbor *n;
-    int randneighbor, i;
-    
-    etimer_set(&et, CLOCK_SECOND * 8 + random_rand() % (CLOCK_SECOND * 8));
-    
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&et));
+  printf("No ACK from %d\n", ping_addr.u8[0]);
+  neighbor_table_missed(&ping_addr);
+  if(ping_retried) {
+    return;
+  }
+  n = neighbor_table_random();
+  if(n != NULL && linkaddr_cmp(&n->addr, &ping_addr)) {
+    n = list_item_next(n) != NULL ? list_item_next(n) : neighbor_table_head();
+  }
+  if(n != NULL) {
+    ping_retried = 1;
+    send_ping(&n->addr, ping_temp);
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* Send a reading to a random neighbor every report period */
+static void
+send_reading(void *ptr)
+{
+  clock_time_t period;
 
-    /* Pick a random neighbor from our list and send a unicast message to it. */
-    if(list_length(neighbors_list) > 0) {
-      randneighbor = random_rand() % list_length(neighbors_list);
-      n = list_head(neighbors_list);
-      for(i = 0; i < randneighbor; i++) {
-        n = list_item_next(n);
-      }
-			int temp_read = temperature();
-      printf("Sending unicast to %d -> Temp = %d\n", n->addr.u8[0], temp_read);
-			if( temp_read > 70){
-				leds_on(LEDS_GREEN);				
-			}else{
-				leds_off(LEDS_GREEN);
-			}
+  struct neighbor *n;
+  int temp;
 
-      msg.temp = temp_read;
-      msg.type = UNICAST_TYPE_PING;
-      packetbuf_copyfrom(&msg, sizeof(msg));
-      unicast_send(&unicast, &n->addr);
-    }
+  /* Pick a random neighbor from our list and send a unicast message to it. */
+  n = neighbor_table_random();
+  if(n == NULL) {
+    sched_set_random(&reading_task, RETRY_MIN, RETRY_MAX, send_reading, NULL);
+    return;
+  }
+  if(temp_sensor_value() != TEMP_SENSOR_INVALID) {
+    temp = temp_sensor_degrees();
+    ping_retried = 0;
+    ping_seqno++;
+    send_ping(&n->addr, temp < 0 ? 0 : (temp > 255 ? 255 : temp));
   }
 
-  PROCESS_END();
+  reading_time = clock_time();
+  period = report_rate_period();
+  sched_set_random(&reading_task, period, period + period / 2,
+                   send_reading, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* When the temperature starts to move, report one new period after the
+   last reading instead of waiting out the old one. */
+static void
+period_changed(clock_time_t period)
+{
+  clock_time_t elapsed, left;
+  int faster;
+
+  printf("Report period %u s\n", report_rate_seconds());
+  faster = period < report_period;
+  report_period = period;
+  if(faster && sched_pending(&reading_task) && neighbor_table_length() > 0) {
+    elapsed = clock_time() - reading_time;
+    left = elapsed < period ? period - elapsed : 0;
+    sched_set_random(&reading_task, left, left + period / 2,
+                     send_reading, NULL);
+  }
+}
+static const struct report_rate_callbacks rate_callbacks = {period_changed};
+/*---------------------------------------------------------------------------*/
+void
+node_role_init(void)
+{
+  report_rate_init(&rate_callbacks);
+  temp_sensor_init(&SENDER_TEMP_DRIVER, &temp_callbacks);
+  sample_log_init();
+  sched_set(&log_task, SAMPLE_LOG_PERIOD, SAMPLE_LOG_PERIOD, log_sample, NULL);
+
+  /* With neighbors restored from flash we can report right away,
+     instead of waiting for the first beacon. */
+  if(neighbor_table_length() > 0) {
+    sched_set(&reading_task, 0, CLOCK_SECOND, send_reading, NULL);
+  } else {
+    sched_set_random(&reading_task, RETRY_MIN, RETRY_MAX, send_reading, NULL);
+  }
 }
 /*---------------------------------------------------------------------------*/
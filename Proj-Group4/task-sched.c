@@ -0,0 +1,104 @@
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/random.h"
+#include "task-sched.h"
+
+LIST(tasks);
+
+static struct ctimer wakeup;
+
+static void run(void *ptr);
+
+/*---------------------------------------------------------------------------*/
+/* Set the wake-up ctimer to the earliest deadline of all tasks, or stop
+   it if there is nothing left to run. */
+static void
+rearm(void)
+{
+  struct sched_task *t;
+  clock_time_t now, elapsed, next, left;
+
+  now = clock_time();
+  next = 0;
+  t = list_head(tasks);
+  if(t == NULL) {
+    ctimer_stop(&wakeup);
+    return;
+  }
+  for(; t != NULL; t = list_item_next(t)) {
+    elapsed = now - t->start;
+    left = elapsed >= t->latest ? 0 : t->latest - elapsed;
+    if(t == list_head(tasks) || left < next) {
+      next = left;
+    }
+  }
+  ctimer_set(&wakeup, next, run, NULL);
+}
+/*---------------------------------------------------------------------------*/
+static void
+run(void *ptr)
+{
+  struct sched_task *t;
+
+  /* Callbacks may set or stop tasks, so start over from the head after
+     each one. A task that sets itself again has a window that starts
+     in the future, and is not picked up twice. The clock is read for
+     every task, since it may tick while a callback runs. */
+  do {
+    for(t = list_head(tasks); t != NULL; t = list_item_next(t)) {
+      if(clock_time() - t->start >= t->earliest) {
+        list_remove(tasks, t);
+        t->f(t->ptr);
+        break;
+      }
+    }
+  } while(t != NULL);
+  rearm();
+}
+/*---------------------------------------------------------------------------*/
+void
+sched_set(struct sched_task *t, clock_time_t earliest, clock_time_t latest,
+          void (*f)(void *), void *ptr)
+{
+  t->start = clock_time();
+  t->earliest = earliest;
+  t->latest = latest < earliest ? earliest : latest;
+  t->f = f;
+  t->ptr = ptr;
+  list_add(tasks, t);
+  rearm();
+}
+/*---------------------------------------------------------------------------*/
+void
+sched_set_random(struct sched_task *t, clock_time_t min, clock_time_t max,
+                 void (*f)(void *), void *ptr)
+{
+  clock_time_t latest;
+
+  latest = min;
+  if(max > min) {
+    latest += random_rand() % (max - min + 1);
+  }
+  sched_set(t, min, latest, f, ptr);
+}
+/*---------------------------------------------------------------------------*/
+void
+sched_stop(struct sched_task *t)
+{
+  list_remove(tasks, t);
+  rearm();
+}
+/*---------------------------------------------------------------------------*/
+int
+sched_pending(struct sched_task *t)
+{
+  struct sched_task *i;
+
+  for(i = list_head(tasks); i != NULL; i = list_item_next(i)) {
+    if(i == t) {
+      return 1;
+    }
+  }
+  return 0;
+}
+/*---------------------------------------------------------------------------*/
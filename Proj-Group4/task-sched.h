@@ -0,0 +1,37 @@
+#ifndef TASK_SCHED_H_
+#define TASK_SCHED_H_
+
+#include "contiki.h"
+
+/* A task runs once, anywhere between ->earliest and ->latest ticks
+   after it was set. The scheduler keeps a single ctimer for the
+   earliest ->latest of all tasks, and when it fires it also runs every
+   other task whose window has already opened. Periodic activities
+   re-arm their task from the callback, like with a ctimer. */
+struct sched_task {
+  struct sched_task *next;
+  clock_time_t start;
+  clock_time_t earliest;
+  clock_time_t latest;
+  void (*f)(void *);
+  void *ptr;
+};
+
+/* Schedule a task to run between earliest and latest ticks from now.
+   Setting a task that is already scheduled moves it. */
+void sched_set(struct sched_task *t, clock_time_t earliest,
+               clock_time_t latest, void (*f)(void *), void *ptr);
+
+/* Like sched_set(), with the latest time picked at random in
+   [min, max]. The task may still run as early as min. This keeps
+   nodes that boot together from transmitting in lockstep. */
+void sched_set_random(struct sched_task *t, clock_time_t min,
+                      clock_time_t max, void (*f)(void *), void *ptr);
+
+/* Cancel a task. */
+void sched_stop(struct sched_task *t);
+
+/* Return non-zero if the task is scheduled. */
+int sched_pending(struct sched_task *t);
+
+#endif /* TASK_SCHED_H_ */
@@ -0,0 +1,63 @@
+#include "contiki.h"
+#include "temp-sensor.h"
+
+/* A linear analog temperature sensor on an ADC channel, like the
+   MCP9700: OFFSET_MV at 0 degrees and MV_PER_DEGREE above that. */
+#ifdef TEMP_ADC_CONF_CHANNEL
+#define TEMP_ADC_CHANNEL TEMP_ADC_CONF_CHANNEL
+#else
+#define TEMP_ADC_CHANNEL 0
+#endif
+
+#ifdef TEMP_ADC_CONF_VREF_MV
+#define TEMP_ADC_VREF_MV TEMP_ADC_CONF_VREF_MV
+#else
+#define TEMP_ADC_VREF_MV 3000
+#endif
+
+#ifdef TEMP_ADC_CONF_OFFSET_MV
+#define TEMP_ADC_OFFSET_MV TEMP_ADC_CONF_OFFSET_MV
+#else
+#define TEMP_ADC_OFFSET_MV 500
+#endif
+
+#ifdef TEMP_ADC_CONF_MV_PER_DEGREE
+#define TEMP_ADC_MV_PER_DEGREE TEMP_ADC_CONF_MV_PER_DEGREE
+#else
+#define TEMP_ADC_MV_PER_DEGREE 10
+#endif
+
+/*---------------------------------------------------------------------------*/
+int
+temp_adc_read(uint8_t channel)
+{
+#ifdef TEMP_ADC_CONF_READ
+  return TEMP_ADC_CONF_READ(channel);
+#else
+  return -1;
+#endif
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  return temp_adc_read(TEMP_ADC_CHANNEL) >= 0;
+}
+/*---------------------------------------------------------------------------*/
+static int16_t
+sample(void)
+{
+  int32_t mv;
+  int count;
+
+  count = temp_adc_read(TEMP_ADC_CHANNEL);
+  if(count < 0) {
+    return TEMP_SENSOR_INVALID;
+  }
+  mv = ((int32_t)count * TEMP_ADC_VREF_MV) >> TEMP_ADC_BITS;
+  return (mv - TEMP_ADC_OFFSET_MV) * (1 << TEMP_SENSOR_SHIFT) /
+    TEMP_ADC_MV_PER_DEGREE;
+}
+/*---------------------------------------------------------------------------*/
+const struct temp_driver temp_adc_driver = {"adc", init, sample};
+/*---------------------------------------------------------------------------*/
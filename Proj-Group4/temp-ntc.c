@@ -0,0 +1,73 @@
+#include "contiki.h"
+#include "temp-sensor.h"
+
+/* The NTC thermistor bridge of hardware/ntc.c. The bridge output is
+   read on an ADC channel referenced to the bridge supply. */
+#ifdef TEMP_NTC_CONF_CHANNEL
+#define TEMP_NTC_CHANNEL TEMP_NTC_CONF_CHANNEL
+#else
+#define TEMP_NTC_CHANNEL 1
+#endif
+
+#define R1 3300
+#define R2 3300
+#define R3 3000
+
+/* Resistance of the NTC in ohms every 5 degrees from -10 to 100,
+   R(T) = RTO * exp(BETA * (1/T - 1/TO)) with the RTO, TO and BETA of
+   hardware/ntc.c. */
+#define TABLE_MIN (-10)
+#define TABLE_STEP 5
+static const uint16_t ntc_table[] = {
+  37227, 29299, 23262, 18622, 15026, 12215, 10000, 8242, 6836, 5705, 4788,
+  4041, 3429, 2924, 2505, 2156, 1864, 1618, 1410, 1234, 1083, 955, 844
+};
+#define TABLE_LEN (sizeof(ntc_table) / sizeof(ntc_table[0]))
+
+/*---------------------------------------------------------------------------*/
+/* Look up the temperature of a resistance, interpolating between the
+   table entries and clamping to the ends of the table. */
+static int16_t
+resistance_to_temp(uint32_t rt)
+{
+  uint8_t i;
+
+  if(rt >= ntc_table[0]) {
+    return TABLE_MIN * (1 << TEMP_SENSOR_SHIFT);
+  }
+  for(i = 1; i < TABLE_LEN; i++) {
+    if(rt > ntc_table[i]) {
+      return (TABLE_MIN + (i - 1) * TABLE_STEP) * (1 << TEMP_SENSOR_SHIFT) +
+        (int16_t)((ntc_table[i - 1] - rt) * (TABLE_STEP << TEMP_SENSOR_SHIFT) /
+                  (ntc_table[i - 1] - ntc_table[i]));
+    }
+  }
+  return (TABLE_MIN + (TABLE_LEN - 1) * TABLE_STEP) * (1 << TEMP_SENSOR_SHIFT);
+}
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  return temp_adc_read(TEMP_NTC_CHANNEL) >= 0;
+}
+/*---------------------------------------------------------------------------*/
+static int16_t
+sample(void)
+{
+  uint32_t aux, rt;
+  int count;
+
+  count = temp_adc_read(TEMP_NTC_CHANNEL);
+  if(count < 0) {
+    return TEMP_SENSOR_INVALID;
+  }
+  /* The same bridge equation as read_temp() in hardware/ntc.c, in 16.16
+     fixed point. */
+  aux = ((uint32_t)count << (16 - TEMP_ADC_BITS)) +
+    ((uint32_t)R2 << 16) / (R2 + R1);
+  rt = R3 * aux / (65536UL + aux);
+  return resistance_to_temp(rt);
+}
+/*---------------------------------------------------------------------------*/
+const struct temp_driver temp_ntc_driver = {"ntc", init, sample};
+/*---------------------------------------------------------------------------*/
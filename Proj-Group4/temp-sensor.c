@@ -0,0 +1,126 @@
+#include "contiki.h"
+#include "temp-sensor.h"
+#include "task-sched.h"
+
+#include <stdio.h>
+
+/* The filter state is kept with 4 more fraction bits than the
+   samples, so that small steps are not lost to rounding. */
+#define FILTER_SHIFT 4
+
+static const struct temp_driver *driver;
+static const struct temp_sensor_callbacks *cb;
+
+static struct sched_task acquire_task;
+static clock_time_t period = TEMP_SENSOR_PERIOD;
+
+static int32_t filtered;
+static uint8_t primed;
+
+/*---------------------------------------------------------------------------*/
+/* Take a burst of samples and return their median, or
+   TEMP_SENSOR_INVALID if none of them was valid. */
+static int16_t
+burst_median(void)
+{
+  int16_t s[TEMP_SENSOR_OVERSAMPLE];
+  int16_t x;
+  uint8_t i, j, n;
+
+  /* Insertion sort as the samples come in. */
+  n = 0;
+  for(i = 0; i < TEMP_SENSOR_OVERSAMPLE; i++) {
+    x = driver->sample();
+    if(x == TEMP_SENSOR_INVALID) {
+      continue;
+    }
+    for(j = n; j > 0 && s[j - 1] > x; j--) {
+      s[j] = s[j - 1];
+    }
+    s[j] = x;
+    n++;
+  }
+  if(n == 0) {
+    return TEMP_SENSOR_INVALID;
+  }
+  return s[n / 2];
+}
+/*---------------------------------------------------------------------------*/
+static void
+acquire(void *ptr)
+{
+  temp_sensor_acquire();
+  sched_set(&acquire_task, period, period + period / 4, acquire, NULL);
+}
+/*---------------------------------------------------------------------------*/
+void
+temp_sensor_set_period(clock_time_t p)
+{
+  period = p;
+  if(driver != NULL) {
+    sched_set(&acquire_task, 0, period, acquire, NULL);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+temp_sensor_init(const struct temp_driver *d,
+                 const struct temp_sensor_callbacks *callbacks)
+{
+  driver = d;
+  cb = callbacks;
+  primed = 0;
+  if(driver == NULL || !driver->init()) {
+    printf("Temperature driver %s not available\n",
+           driver != NULL ? driver->name : "(none)");
+    driver = NULL;
+    return;
+  }
+  acquire(NULL);
+}
+/*---------------------------------------------------------------------------*/
+int16_t
+temp_sensor_acquire(void)
+{
+  int16_t x;
+
+  if(driver == NULL) {
+    return TEMP_SENSOR_INVALID;
+  }
+  x = burst_median();
+  if(x == TEMP_SENSOR_INVALID) {
+    return temp_sensor_value();
+  }
+  if(!primed) {
+    filtered = (int32_t)x << FILTER_SHIFT;
+    primed = 1;
+  } else {
+    filtered += (((int32_t)x << FILTER_SHIFT) - filtered)
+      >> TEMP_SENSOR_IIR_SHIFT;
+  }
+  if(cb != NULL && cb->sampled != NULL) {
+    cb->sampled(temp_sensor_value());
+  }
+  return temp_sensor_value();
+}
+/*---------------------------------------------------------------------------*/
+int16_t
+temp_sensor_value(void)
+{
+  if(!primed) {
+    return TEMP_SENSOR_INVALID;
+  }
+  return (filtered + (1 << (FILTER_SHIFT - 1))) >> FILTER_SHIFT;
+}
+/*---------------------------------------------------------------------------*/
+int
+temp_sensor_degrees(void)
+{
+  int16_t t;
+
+  t = temp_sensor_value();
+  if(t == TEMP_SENSOR_INVALID) {
+    return TEMP_SENSOR_INVALID;
+  }
+  return (t + (1 << (TEMP_SENSOR_SHIFT - 1))) >> TEMP_SENSOR_SHIFT;
+}
+/*---------------------------------------------------------------------------*/
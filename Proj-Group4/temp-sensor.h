@@ -0,0 +1,86 @@
+#ifndef TEMP_SENSOR_H_
+#define TEMP_SENSOR_H_
+
+#include "contiki.h"
+
+/* Temperatures are fixed point with TEMP_SENSOR_SHIFT fraction bits,
+   that is in 1/16 degree Celsius. */
+#define TEMP_SENSOR_SHIFT 4
+#define TEMP_SENSOR_INVALID (-32767 - 1)
+
+/* Each acquisition takes a burst of this many raw samples and keeps
+   their median, which removes single-sample spikes. Must be odd, and
+   at most 9. */
+#ifdef TEMP_SENSOR_CONF_OVERSAMPLE
+#define TEMP_SENSOR_OVERSAMPLE TEMP_SENSOR_CONF_OVERSAMPLE
+#else
+#define TEMP_SENSOR_OVERSAMPLE 5
+#endif
+
+/* The medians are smoothed by a first-order IIR filter with a gain of
+   1 / 2^IIR_SHIFT. */
+#ifdef TEMP_SENSOR_CONF_IIR_SHIFT
+#define TEMP_SENSOR_IIR_SHIFT TEMP_SENSOR_CONF_IIR_SHIFT
+#else
+#define TEMP_SENSOR_IIR_SHIFT 2
+#endif
+
+/* How often an acquisition is made by default. This is independent of
+   how often readings are reported, so that the filter sees a steady
+   rate, but it can be slowed down with temp_sensor_set_period(). */
+#ifdef TEMP_SENSOR_CONF_PERIOD
+#define TEMP_SENSOR_PERIOD TEMP_SENSOR_CONF_PERIOD
+#else
+#define TEMP_SENSOR_PERIOD (2 * CLOCK_SECOND)
+#endif
+
+/* A temperature driver, see temp-adc.c, temp-ntc.c and temp-trace.c. */
+struct temp_driver {
+  const char *name;
+  /* Prepare the sensor. Returns zero if it is not present. */
+  int (*init)(void);
+  /* Take one raw sample, or return TEMP_SENSOR_INVALID. */
+  int16_t (*sample)(void);
+};
+
+extern const struct temp_driver temp_adc_driver;
+extern const struct temp_driver temp_ntc_driver;
+extern const struct temp_driver temp_trace_driver;
+
+/* Raw conversion of an ADC channel, shared by the ADC and NTC drivers.
+   The platform supplies it as TEMP_ADC_CONF_READ(channel), returning a
+   count of TEMP_ADC_BITS referenced to the supply. Returns -1 if the
+   platform has no ADC. */
+#ifdef TEMP_ADC_CONF_BITS
+#define TEMP_ADC_BITS TEMP_ADC_CONF_BITS
+#else
+#define TEMP_ADC_BITS 10
+#endif
+
+int temp_adc_read(uint8_t channel);
+
+struct temp_sensor_callbacks {
+  /* Called with every new filtered temperature. */
+  void (*sampled)(int16_t temp);
+};
+
+/* Start acquiring from a driver every TEMP_SENSOR_PERIOD. The first
+   acquisition is made right away. */
+void temp_sensor_init(const struct temp_driver *driver,
+                      const struct temp_sensor_callbacks *callbacks);
+
+/* Change the time between acquisitions. The next one is made within
+   the new period. */
+void temp_sensor_set_period(clock_time_t period);
+
+/* Take an acquisition now, and return the new filtered temperature. */
+int16_t temp_sensor_acquire(void);
+
+/* The latest filtered temperature, or TEMP_SENSOR_INVALID if there is
+   none yet. */
+int16_t temp_sensor_value(void);
+
+/* The latest filtered temperature rounded to whole degrees. */
+int temp_sensor_degrees(void);
+
+#endif /* TEMP_SENSOR_H_ */
@@ -0,0 +1,106 @@
+#include "contiki.h"
+#include "cfs/cfs.h"
+#include "lib/random.h"
+#include "temp-sensor.h"
+
+/* Replays raw samples from a trace file, for testing the pipeline in
+   Cooja and on the host. The file holds one sample per line in degrees,
+   like "21.5", and is replayed in a loop. Without the file the driver
+   falls back to a noisy synthetic ramp from 40 to 100 degrees. */
+#ifdef TEMP_TRACE_CONF_FILE
+#define TEMP_TRACE_FILE TEMP_TRACE_CONF_FILE
+#else
+#define TEMP_TRACE_FILE "temp.trace"
+#endif
+
+/* The ramp climbs RATE degrees every 12 seconds, like the readings of
+   the old sender did, and adds up to NOISE/16 degrees of noise. */
+#define RAMP_MIN 40
+#define RAMP_PERIOD 220
+#define RAMP_RATE_X100 327
+#define RAMP_NOISE 16
+
+static int fd = -1;
+
+/*---------------------------------------------------------------------------*/
+static int
+init(void)
+{
+  fd = cfs_open(TEMP_TRACE_FILE, CFS_READ);
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+static int16_t
+ramp(void)
+{
+  int32_t t;
+
+  t = (clock_seconds() % RAMP_PERIOD) * (RAMP_RATE_X100 << TEMP_SENSOR_SHIFT) /
+    (12 * 100);
+  return (RAMP_MIN << TEMP_SENSOR_SHIFT) + t +
+    (int16_t)(random_rand() % (2 * RAMP_NOISE + 1)) - RAMP_NOISE;
+}
+/*---------------------------------------------------------------------------*/
+/* Parse the next line of the trace, rewinding at its end. Returns
+   TEMP_SENSOR_INVALID if the trace has no samples. */
+static int16_t
+next_line(void)
+{
+  int32_t value, frac;
+  uint8_t rewound, neg, digits;
+  char c;
+
+  rewound = 0;
+  while(1) {
+    value = 0;
+    frac = 0;
+    neg = 0;
+    digits = 0;
+    while(1) {
+      if(cfs_read(fd, &c, 1) != 1) {
+        c = '\n';
+        if(digits == 0) {
+          if(rewound) {
+            return TEMP_SENSOR_INVALID;
+          }
+          cfs_seek(fd, 0, CFS_SEEK_SET);
+          rewound = 1;
+          break;
+        }
+      }
+      if(c == '\n') {
+        break;
+      } else if(c == '-' && digits == 0) {
+        neg = 1;
+      } else if(c == '.' && frac == 0) {
+        frac = 1;
+      } else if(c >= '0' && c <= '9') {
+        value = value * 10 + (c - '0');
+        digits++;
+        if(frac) {
+          frac *= 10;
+        }
+      }
+    }
+    if(digits > 0) {
+      break;
+    }
+  }
+  if(frac == 0) {
+    frac = 1;
+  }
+  value = (value * (1 << TEMP_SENSOR_SHIFT) + frac / 2) / frac;
+  return neg ? -value : value;
+}
+/*---------------------------------------------------------------------------*/
+static int16_t
+sample(void)
+{
+  if(fd < 0) {
+    return ramp();
+  }
+  return next_line();
+}
+/*---------------------------------------------------------------------------*/
+const struct temp_driver temp_trace_driver = {"trace", init, sample};
+/*---------------------------------------------------------------------------*/
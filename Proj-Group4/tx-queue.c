@@ -0,0 +1,199 @@
+#include "contiki.h"
+#include "lib/list.h"
+#include "lib/memb.h"
+#include "tx-queue.h"
+#include "task-sched.h"
+
+#include <stdio.h>
+#include <string.h>
+
+struct tx_entry {
+  struct tx_entry *next;
+  linkaddr_t to;
+  uint8_t class;
+  uint8_t broadcast;
+  uint8_t len;
+  uint8_t data[TX_QUEUE_MAX_LEN];
+};
+
+/* The queue is kept sorted by class, and in arrival order within a
+   class. */
+MEMB(tx_memb, struct tx_entry, TX_QUEUE_SIZE);
+LIST(tx_list);
+
+/* Telemetry and discovery are rate limited to a burst of ->burst
+   messages, and one more every ->interval after that. */
+struct tx_limit {
+  clock_time_t interval;
+  uint8_t burst;
+};
+static const struct tx_limit limits[TX_CLASSES] = {
+  { 0, 0 },                     /* control */
+  { 0, 0 },                     /* ack */
+  { CLOCK_SECOND / 4, 4 },      /* telemetry */
+  { CLOCK_SECOND, 2 }           /* discovery */
+};
+static uint8_t tokens[TX_CLASSES];
+static clock_time_t refilled[TX_CLASSES];
+
+static struct sched_task drain_task;
+static clock_time_t last_tx;
+
+static const struct tx_queue_callbacks *cb;
+
+static void drain(void *ptr);
+
+/*---------------------------------------------------------------------------*/
+/* Add the tokens a class earned since its last refill, and return how
+   long it has to wait for its next token, or 0 if it has one. */
+static clock_time_t
+refill(uint8_t class)
+{
+  const struct tx_limit *l = &limits[class];
+  clock_time_t elapsed, n;
+
+  if(l->burst == 0) {
+    return 0;
+  }
+  elapsed = clock_time() - refilled[class];
+  n = elapsed / l->interval;
+  if(n >= (clock_time_t)(l->burst - tokens[class])) {
+    tokens[class] = l->burst;
+    refilled[class] = clock_time();
+  } else if(n > 0) {
+    tokens[class] += n;
+    refilled[class] += n * l->interval;
+  }
+  if(tokens[class] > 0) {
+    return 0;
+  }
+  return l->interval - (clock_time() - refilled[class]);
+}
+/*---------------------------------------------------------------------------*/
+/* Schedule the next drain, no earlier than the gap after the last
+   message. */
+static void
+schedule(clock_time_t wait)
+{
+  clock_time_t since;
+
+  since = clock_time() - last_tx;
+  if(since < TX_QUEUE_GAP && wait < TX_QUEUE_GAP - since) {
+    wait = TX_QUEUE_GAP - since;
+  }
+  sched_set(&drain_task, wait, wait, drain, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Send the first message whose class is not held back by its rate
+   limit. */
+static void
+drain(void *ptr)
+{
+  struct tx_entry *e;
+  clock_time_t wait, min_wait;
+
+  min_wait = 0;
+  for(e = list_head(tx_list); e != NULL; e = list_item_next(e)) {
+    wait = refill(e->class);
+    if(wait == 0) {
+      break;
+    }
+    if(min_wait == 0 || wait < min_wait) {
+      min_wait = wait;
+    }
+  }
+
+  if(e != NULL) {
+    list_remove(tx_list, e);
+    if(limits[e->class].burst > 0) {
+      tokens[e->class]--;
+    }
+    last_tx = clock_time();
+    if(cb != NULL && cb->send != NULL) {
+      cb->send(e->broadcast ? NULL : &e->to, e->data, e->len);
+    }
+    memb_free(&tx_memb, e);
+    min_wait = 0;
+  }
+
+  if(list_head(tx_list) != NULL) {
+    schedule(min_wait);
+  }
+}
+/*---------------------------------------------------------------------------*/
+void
+tx_queue_init(const struct tx_queue_callbacks *callbacks)
+{
+  uint8_t c;
+
+  cb = callbacks;
+  memb_init(&tx_memb);
+  list_init(tx_list);
+  for(c = 0; c < TX_CLASSES; c++) {
+    tokens[c] = limits[c].burst;
+    refilled[c] = clock_time();
+  }
+  last_tx = clock_time() - TX_QUEUE_GAP;
+}
+/*---------------------------------------------------------------------------*/
+int
+tx_queue_send(uint8_t class, const linkaddr_t *to,
+              const void *data, uint8_t len)
+{
+  struct tx_entry *e, *prev, *victim;
+
+  if(class >= TX_CLASSES || len > TX_QUEUE_MAX_LEN) {
+    return 0;
+  }
+
+  e = memb_alloc(&tx_memb);
+  if(e == NULL) {
+    /* Evict the oldest message of the lowest class, if that class is
+       below ours. */
+    victim = NULL;
+    for(prev = list_head(tx_list); prev != NULL; prev = list_item_next(prev)) {
+      if(victim == NULL || prev->class > victim->class) {
+        victim = prev;
+      }
+    }
+    if(victim == NULL || victim->class <= class) {
+      printf("TX queue full, dropped class %d\n", class);
+      return 0;
+    }
+    printf("TX queue full, evicted class %d\n", victim->class);
+    list_remove(tx_list, victim);
+    e = victim;
+  }
+
+  e->class = class;
+  e->broadcast = to == NULL;
+  if(to != NULL) {
+    linkaddr_copy(&e->to, to);
+  }
+  e->len = len;
+  memcpy(e->data, data, len);
+
+  /* Insert after the last message of the same or a higher class. */
+  prev = NULL;
+  for(victim = list_head(tx_list); victim != NULL &&
+        victim->class <= class; victim = list_item_next(victim)) {
+    prev = victim;
+  }
+  if(prev == NULL) {
+    list_push(tx_list, e);
+  } else {
+    list_insert(tx_list, prev, e);
+  }
+
+  if(!sched_pending(&drain_task) || list_head(tx_list) == e) {
+    schedule(0);
+  }
+  return 1;
+}
+/*---------------------------------------------------------------------------*/
+uint8_t
+tx_queue_length(void)
+{
+  return list_length(tx_list);
+}
+/*---------------------------------------------------------------------------*/
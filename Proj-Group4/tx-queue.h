@@ -0,0 +1,58 @@
+#ifndef TX_QUEUE_H_
+#define TX_QUEUE_H_
+
+#include "contiki.h"
+#include "net/linkaddr.h"
+
+/* Outgoing messages are queued by class and sent one at a time from a
+   task, never from inside a receive callback. A lower class is only
+   sent when no higher class is waiting, so an AC command waits for at
+   most one message already handed to the MAC, plus the queue gap. */
+enum {
+  TX_CLASS_CONTROL,
+  TX_CLASS_ACK,
+  TX_CLASS_TELEMETRY,
+  TX_CLASS_DISCOVERY,
+  TX_CLASSES
+};
+
+/* The number of messages that can wait in the queue. When it is full,
+   a message evicts the oldest message of the lowest class below its
+   own, or is dropped. */
+#ifdef TX_QUEUE_CONF_SIZE
+#define TX_QUEUE_SIZE TX_QUEUE_CONF_SIZE
+#else
+#define TX_QUEUE_SIZE 6
+#endif
+
+/* The largest message that can be queued. */
+#ifdef TX_QUEUE_CONF_MAX_LEN
+#define TX_QUEUE_MAX_LEN TX_QUEUE_CONF_MAX_LEN
+#else
+#define TX_QUEUE_MAX_LEN 8
+#endif
+
+/* The time between two messages, which leaves room for a message of a
+   higher class to overtake the queue. */
+#ifdef TX_QUEUE_CONF_GAP
+#define TX_QUEUE_GAP TX_QUEUE_CONF_GAP
+#else
+#define TX_QUEUE_GAP (CLOCK_SECOND >= 128 ? CLOCK_SECOND / 128 : 1)
+#endif
+
+struct tx_queue_callbacks {
+  /* Send a message now. to is NULL for a broadcast. */
+  void (*send)(const linkaddr_t *to, const void *data, uint8_t len);
+};
+
+void tx_queue_init(const struct tx_queue_callbacks *callbacks);
+
+/* Queue a message of a class for sending. to is NULL for a broadcast.
+   Returns zero if the message was dropped. */
+int tx_queue_send(uint8_t class, const linkaddr_t *to,
+                  const void *data, uint8_t len);
+
+/* Return the number of messages waiting. */
+uint8_t tx_queue_length(void);
+
+#endif /* TX_QUEUE_H_ */
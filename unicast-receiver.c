@@ -53,6 +53,78 @@
 #define SEND_INTERVAL		(60 * CLOCK_SECOND)
 #define SEND_TIME		(random_rand() % (SEND_INTERVAL))
 
+/* Every sender has a session, found by the interface ID of its
+   address in an open addressing hash table. The table size must be a
+   power of two, and only 7/8 of it is filled. Each session costs 22
+   bytes of RAM. */
+#ifdef RECEIVER_CONF_MAX_SESSIONS
+#define MAX_SESSIONS RECEIVER_CONF_MAX_SESSIONS
+#else
+#define MAX_SESSIONS 128
+#endif
+#define MAX_LOAD (MAX_SESSIONS - MAX_SESSIONS / 8)
+
+/* Readings are not acknowledged one by one. A sender gets a single ACK
+   for all its readings once ACK_BATCH of them are waiting, or ACK_DELAY
+   seconds after the first of them, which cuts the downward traffic of
+   the RPL root by up to ACK_BATCH times. At the slowest report period
+   of 64 s, a sender waits at least 32 s between readings. ACK_DELAY
+   plus one sweep stays below that, so such a sender still hears
+   about each reading before it sends the next. Only the fast senders,
+   which make most of the traffic, are batched. */
+#ifdef RECEIVER_CONF_ACK_BATCH
+#define ACK_BATCH RECEIVER_CONF_ACK_BATCH
+#else
+#define ACK_BATCH 8
+#endif
+
+#ifdef RECEIVER_CONF_ACK_DELAY
+#define ACK_DELAY RECEIVER_CONF_ACK_DELAY
+#else
+#define ACK_DELAY 24
+#endif
+
+/* The sessions are swept for due ACKs every ACK_SWEEP. At most
+   ACKS_PER_SWEEP ACKs are sent at once, the rest follow ACK_SPACING
+   later, so that the root does not flood its MAC queue. */
+#define ACK_SWEEP (ACK_DELAY / 8 * CLOCK_SECOND)
+#define ACKS_PER_SWEEP 4
+#define ACK_SPACING (CLOCK_SECOND / 8)
+
+/* Sessions of senders that stopped reporting are dropped after
+   SESSION_TIMEOUT seconds, or four of their report periods if that is
+   longer. */
+#define SESSION_TIMEOUT 300
+
+/* A reading up to SEQ_REORDER behind the last one is late and is
+   dropped. One further behind, or one of the first SEQ_REORDER after a
+   later one, means that the sender restarted and numbers its readings
+   from 0 again, so its session starts over. */
+#define SEQ_REORDER 4
+
+/* Session flags. */
+#define SESSION_USED 0x01
+#define SESSION_SEQ  0x02
+
+struct session {
+  uint8_t iid[8];
+  /* The last sequence number, if SESSION_SEQ is set. */
+  uint16_t seq;
+  /* The number of readings lost in a gap of sequence numbers. */
+  uint16_t lost;
+  int16_t temp;
+  /* The report period announced by the sender in seconds, or 0. */
+  uint8_t period;
+  uint8_t unacked;
+  uint8_t flags;
+  uint16_t last_seen;
+  uint16_t ack_since;
+};
+
+static struct session sessions[MAX_SESSIONS];
+static uint16_t session_count;
+static struct ctimer ack_timer;
+
 static struct simple_udp_connection unicast_connection;
 static struct simple_udp_connection broadcast_connection;
 
@@ -63,6 +135,170 @@ AUTOSTART_PROCESSES(&unicast_receiver_process,&broadcast_example_process);
 
 
 /*---------------------------------------------------------------------------*/
+static uint16_t
+slot(const uint8_t *iid)
+{
+  uint16_t h;
+  uint8_t i;
+
+  h = 0;
+  for(i = 0; i < 8; i++) {
+    h = h * 31 + iid[i];
+  }
+  return h & (MAX_SESSIONS - 1);
+}
+/*---------------------------------------------------------------------------*/
+/* Find the session of an interface ID. If there is none, a new one is
+   made if create is set and the table has room. */
+static struct session *
+lookup(const uint8_t *iid, int create)
+{
+  uint16_t i;
+
+  i = slot(iid);
+  while(sessions[i].flags & SESSION_USED) {
+    if(memcmp(sessions[i].iid, iid, 8) == 0) {
+      return &sessions[i];
+    }
+    i = (i + 1) & (MAX_SESSIONS - 1);
+  }
+  if(!create || session_count >= MAX_LOAD) {
+    return NULL;
+  }
+  memset(&sessions[i], 0, sizeof(struct session));
+  memcpy(sessions[i].iid, iid, 8);
+  sessions[i].flags = SESSION_USED;
+  session_count++;
+  return &sessions[i];
+}
+/*---------------------------------------------------------------------------*/
+/* Remove a session, shifting later sessions of the same probe sequence
+   back so that lookups never hit a hole. */
+static void
+remove_session(struct session *s)
+{
+  uint16_t i, j, k;
+
+  session_count--;
+  i = s - sessions;
+  j = i;
+  while(1) {
+    sessions[i].flags = 0;
+    while(1) {
+      j = (j + 1) & (MAX_SESSIONS - 1);
+      if(!(sessions[j].flags & SESSION_USED)) {
+        return;
+      }
+      k = slot(sessions[j].iid);
+      /* Session j can be moved into the hole at i unless its home slot
+         k lies cyclically in (i, j]. */
+      if((i <= j) ? ((i < k) && (k <= j)) : ((i < k) || (k <= j))) {
+        continue;
+      }
+      break;
+    }
+    memcpy(&sessions[i], &sessions[j], sizeof(struct session));
+    i = j;
+  }
+}
+/*---------------------------------------------------------------------------*/
+/* A short name for a sender, the last two bytes of its interface ID. */
+static unsigned int
+session_id(const struct session *s)
+{
+  return (s->iid[6] << 8) | s->iid[7];
+}
+/*---------------------------------------------------------------------------*/
+/* Acknowledge all the readings of a session up to its last sequence
+   number. Senders take their global address from the same prefix as
+   ours, so the address is rebuilt from the interface ID. */
+static void
+send_ack(struct session *s)
+{
+  uip_ipaddr_t addr;
+  char buf[12];
+
+  uip_ip6addr(&addr, 0xaaaa, 0, 0, 0, 0, 0, 0, 0);
+  memcpy(&addr.u8[8], s->iid, 8);
+  sprintf(buf, "ACK %u", s->seq);
+  simple_udp_sendto(&unicast_connection, buf, strlen(buf) + 1, &addr);
+  s->unacked = 0;
+}
+/*---------------------------------------------------------------------------*/
+static uint16_t
+session_timeout(const struct session *s)
+{
+  uint16_t t;
+
+  t = (uint16_t)s->period * 4;
+  return t > SESSION_TIMEOUT ? t : SESSION_TIMEOUT;
+}
+/*---------------------------------------------------------------------------*/
+/* Send the ACKs that are due and drop the sessions that timed out. */
+static void
+sweep_sessions(void *ptr)
+{
+  uint16_t now, i;
+  uint8_t sent;
+  struct session *s;
+
+  now = (uint16_t)clock_seconds();
+  sent = 0;
+  i = 0;
+  while(i < MAX_SESSIONS) {
+    s = &sessions[i];
+    if(!(s->flags & SESSION_USED)) {
+      i++;
+      continue;
+    }
+    if(s->unacked > 0 && (uint16_t)(now - s->ack_since) >= ACK_DELAY) {
+      if(sent == ACKS_PER_SWEEP) {
+        ctimer_set(&ack_timer, ACK_SPACING, sweep_sessions, NULL);
+        return;
+      }
+      send_ack(s);
+      sent++;
+    }
+    if((uint16_t)(now - s->last_seen) > session_timeout(s)) {
+      printf("Session %04x timed out, %u lost\n", session_id(s), s->lost);
+      /* Removing may shift another session into slot i, so look at the
+         same slot again. */
+      remove_session(s);
+      continue;
+    }
+    i++;
+  }
+  ctimer_set(&ack_timer, ACK_SWEEP, sweep_sessions, NULL);
+}
+/*---------------------------------------------------------------------------*/
+/* Parse the next decimal number of a reading. Returns NULL if there is
+   none. */
+static const uint8_t *
+next_number(const uint8_t *p, const uint8_t *end, int32_t *v)
+{
+  int neg;
+
+  while(p < end && *p == ' ') {
+    p++;
+  }
+  neg = p < end && *p == '-';
+  if(neg) {
+    p++;
+  }
+  if(p >= end || *p < '0' || *p > '9') {
+    return NULL;
+  }
+  for(*v = 0; p < end && *p >= '0' && *p <= '9'; p++) {
+    *v = *v * 10 + (*p - '0');
+  }
+  if(neg) {
+    *v = -*v;
+  }
+  return p;
+}
+/*---------------------------------------------------------------------------*/
+/* A reading is "<temp> [<period> [<seqno>]]", see unicast-sender-temp.c.
+   Older senders leave out the period and the sequence number. */
 static void
 receiver(struct simple_udp_connection *c,
          const uip_ipaddr_t *sender_addr,
@@ -72,11 +308,57 @@ receiver(struct simple_udp_connection *c,
          const uint8_t *data,
          uint16_t datalen)
 {
-  printf("Data received  from node ");
-  uip_debug_ipaddr_print(sender_addr);
-  printf(" on port %d from port %d with length %d: '%s'\n",
-         receiver_port, sender_port, datalen, data);
-  simple_udp_sendto(&unicast_connection, "ACK", 4, sender_addr);
+  const uint8_t *p, *end;
+  struct session *s;
+  int32_t temp, period, seq;
+  uint16_t gap;
+
+  end = data + datalen;
+  p = next_number(data, end, &temp);
+  if(p == NULL) {
+    return;
+  }
+  s = lookup(&sender_addr->u8[8], 1);
+  if(s == NULL) {
+    printf("Session table full\n");
+    return;
+  }
+
+  if((p = next_number(p, end, &period)) != NULL) {
+    s->period = period < 0 ? 0 : (period > 255 ? 255 : period);
+  }
+  if(p != NULL && next_number(p, end, &seq) != NULL) {
+    if(s->flags & SESSION_SEQ) {
+      gap = (uint16_t)seq - s->seq;
+      /* Duplicates and late readings are not counted again. */
+      if(gap == 0 || ((uint16_t)-gap <= SEQ_REORDER &&
+                      (uint16_t)seq >= SEQ_REORDER)) {
+        return;
+      }
+      if(gap >= 0x8000) {
+        printf("Session %04x restarted at seq %u\n", session_id(s),
+               (uint16_t)seq);
+        s->lost = 0;
+        s->unacked = 0;
+      } else {
+        s->lost += gap - 1;
+      }
+    }
+    s->seq = seq;
+    s->flags |= SESSION_SEQ;
+  }
+  s->temp = temp;
+  s->last_seen = (uint16_t)clock_seconds();
+
+  printf("Reading from %04x: %d, period %u s, seq %u, lost %u\n",
+         session_id(s), s->temp, s->period, s->seq, s->lost);
+
+  if(s->unacked++ == 0) {
+    s->ack_since = s->last_seen;
+  }
+  if(s->unacked >= ACK_BATCH) {
+    send_ack(s);
+  }
 }
 
 static void
@@ -154,6 +436,7 @@ PROCESS_THREAD(unicast_receiver_process, ev, data)
 
   simple_udp_register(&unicast_connection, UDP_PORT,
                       NULL, UDP_PORT, receiver);
+  ctimer_set(&ack_timer, ACK_SWEEP, sweep_sessions, NULL);
 
   while(1) {
     PROCESS_WAIT_EVENT();
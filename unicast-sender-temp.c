@@ -41,36 +41,26 @@
 
 #include "simple-udp.h"
 #include "servreg-hack.h"
+/* The acquisition pipeline of Proj-Group4: build with
+   PROJECT_SOURCEFILES += temp-sensor.c temp-trace.c task-sched.c
+   report-rate.c */
+#include "temp-sensor.h"
+#include "report-rate.h"
 #include <math.h>
 #include <stdio.h>
 #include <string.h>
 
-#define VCC 5
-#define R1 3300
-#define R2 3300
-#define R3 3000
-#define BETA 3380
-#define RTO 10000
-#define TO 293.15 
-
-
 #define UDP_PORT 1234
 #define SERVICE_ID 190
 
-#define SEND_INTERVAL		(20 * CLOCK_SECOND)
-#define SEND_TIME		(random_rand() % (SEND_INTERVAL))
-
-#define base_VOUT		3
-#define VOUT 		(random_rand() % (basic_vout))
-
-#define RATE 1.2
-#define MAXTEMP_VARI 70
-#define MINTEMP 20
+/* Readings are sent every report period of report-rate.c, give or take
+   half a period. */
+#define SEND_TIME(p)		((p) / 2 + random_rand() % (p))
 
 static struct simple_udp_connection unicast_connection;
 
-
-static int temp_idx=0;
+/* Readings are numbered, so that the sink can count the lost ones. */
+static uint16_t seqno;
 
 /*---------------------------------------------------------------------------*/
 PROCESS(unicast_sender_process, "Unicast sender example process");
@@ -85,31 +75,39 @@ receiver(struct simple_udp_connection *c,
          const uint8_t *data,
          uint16_t datalen)
 {
-    printf("Received ACK ");
+    /* The sink acknowledges all readings up to a sequence number at
+       once, see unicast-receiver.c. */
+    printf("Received %s from ", data);
     uip_debug_ipaddr_print(sender_addr);
     printf("\n");
 }
 static int
 temperature(void)
 {
-      /*
-
-      double variance =  (base_VOUT + VOUT);
-      double aux_Wbridge = ((double)(variance)/(double)VCC) + (double)(R2/(double)(R2+R1));
-      double Rt = R3* aux_Wbridge /(1+ aux_Wbridge);
-      return  (int)((1/((1/(double)TO))) + (((Rt/(double)RTO)/(double)BETA) - 273.15));//  log(rt/ro) Temperature in Celsius
-      
-      */
-  if(temp_idx >= MAXTEMP_VARI){
-    temp_idx =0;
+  /* The filtered temperature from the acquisition pipeline, which runs
+     on its own period. The NTC bridge math lives in temp-ntc.c. Until
+     the sensor gives a valid sample there is none. */
+  if(temp_sensor_value() == TEMP_SENSOR_INVALID) {
+    return TEMP_SENSOR_INVALID;
   }
-  else{
-    ++temp_idx;
-  }
-
-  return  temp_idx* RATE + MINTEMP;
+  return temp_sensor_degrees();
+}
+/*---------------------------------------------------------------------------*/
+/* Wake up the process when the temperature starts to move, so that it
+   does not wait out the previous period. */
+static clock_time_t report_period = REPORT_RATE_MAX;
 
+static void
+period_changed(clock_time_t period)
+{
+  if(period < report_period) {
+    process_poll(&unicast_sender_process);
+  }
+  report_period = period;
 }
+static const struct report_rate_callbacks rate_callbacks = {period_changed};
+static const struct temp_sensor_callbacks temp_callbacks =
+  {report_rate_sampled};
 /*---------------------------------------------------------------------------*/
 static void
 set_global_address(void)
@@ -135,7 +133,6 @@ set_global_address(void)
 /*---------------------------------------------------------------------------*/
 PROCESS_THREAD(unicast_sender_process, ev, data)
 {
-  static struct etimer periodic_timer;
   static struct etimer send_timer;
   uip_ipaddr_t *addr;
         
@@ -146,17 +143,27 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
 
   set_global_address();
 
+  report_rate_init(&rate_callbacks);
+  temp_sensor_init(&temp_trace_driver, &temp_callbacks);
+
   simple_udp_register(&unicast_connection, UDP_PORT,
                       NULL, UDP_PORT, receiver);
 
-  etimer_set(&periodic_timer, SEND_INTERVAL);
+  etimer_set(&send_timer, SEND_TIME(report_rate_period()));
   while(1) {
 
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&periodic_timer));
-    etimer_reset(&periodic_timer);
-    etimer_set(&send_timer, SEND_TIME);
-
-    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&send_timer));
+    PROCESS_WAIT_EVENT_UNTIL(etimer_expired(&send_timer) ||
+                             ev == PROCESS_EVENT_POLL);
+    if(ev == PROCESS_EVENT_POLL) {
+      etimer_set(&send_timer, random_rand() % report_rate_period());
+      continue;
+    }
+    etimer_set(&send_timer, SEND_TIME(report_rate_period()));
+    /* Like sender.c, send nothing without a valid temperature. */
+    if(temperature() == TEMP_SENSOR_INVALID) {
+      printf("No valid temperature, reading skipped\n");
+      continue;
+    }
     addr = servreg_hack_lookup(SERVICE_ID);
     if(addr != NULL) {
       static unsigned int message_number;
@@ -170,7 +177,9 @@ PROCESS_THREAD(unicast_sender_process, ev, data)
       message_number = temperature();
       //printf("send temp %i \n",message_number);
       
-      sprintf(buf, "%d", message_number);
+      /* The period tells the sink how long to wait for the next one. */
+      sprintf(buf, "%d %u %u", message_number, report_rate_seconds(),
+              seqno++);
       //message_number++;
       simple_udp_sendto(&unicast_connection, buf, strlen(buf) + 1, addr);
     } else {